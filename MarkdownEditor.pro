@@ -14,26 +14,44 @@ CONFIG += c++14  # <-- 新增這一行，啟用 C++14 標準
 #DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
 
 SOURCES += \
+    documentcache.cpp \
+    editorgutter.cpp \
+    executorpanel.cpp \
+    highlighttokenizer.cpp \
     main.cpp \
     mainwindow.cpp \
-    markdownhighlighter.cpp
+    markdownhighlighter.cpp \
+    parserwarmup.cpp \
+    previewimagecache.cpp \
+    previewschemehandler.cpp \
+    rendercache.cpp \
+    taskexecutor.cpp \
+    textbrowserpreview.cpp \
+    webenginepreview.cpp
 
 HEADERS += \
     maddy/blockparser.h \
     maddy/breaklineparser.h \
     maddy/checklistparser.h \
     maddy/codeblockparser.h \
+    maddy/documentformat.h \
     maddy/emphasizedparser.h \
     maddy/headlineparser.h \
     maddy/horizontallineparser.h \
+    maddy/htmlescaper.h \
     maddy/htmlparser.h \
     maddy/imageparser.h \
     maddy/inlinecodeparser.h \
+    maddy/inlinememo.h \
     maddy/italicparser.h \
     maddy/latexblockparser.h \
+    maddy/linematcher.h \
     maddy/lineparser.h \
+    maddy/linetokenizer.h \
     maddy/linkparser.h \
+    maddy/listparser.h \
     maddy/orderedlistparser.h \
+    maddy/outline.h \
     maddy/paragraphparser.h \
     maddy/parser.h \
     maddy/parserconfig.h \
@@ -42,8 +60,21 @@ HEADERS += \
     maddy/strongparser.h \
     maddy/tableparser.h \
     maddy/unorderedlistparser.h \
+    contenthash.h \
+    documentcache.h \
+    editorgutter.h \
+    executorpanel.h \
+    highlighttokenizer.h \
     mainwindow.h \
-    markdownhighlighter.h
+    markdownhighlighter.h \
+    parserwarmup.h \
+    previewbackend.h \
+    previewimagecache.h \
+    previewschemehandler.h \
+    rendercache.h \
+    taskexecutor.h \
+    textbrowserpreview.h \
+    webenginepreview.h
 
 FORMS += \
     mainwindow.ui
@@ -0,0 +1,65 @@
+// contenthash.h
+
+#ifndef CONTENTHASH_H
+#define CONTENTHASH_H
+
+#include <QString>
+#include <QtGlobal>
+
+#include <string.h>
+
+// 64 位元內容雜湊 (FNV-1a 的變形，每次處理 8 個位元組)。
+// 與 qHash 不同，結果不含每次執行不同的種子，只取決於內容
+class ContentHash
+{
+public:
+
+    ContentHash() : m_state(kOffsetBasis), m_length(0) {}
+
+    ContentHash &add(const void *data, size_t length)
+    {
+        const uchar *bytes = static_cast<const uchar *>(data);
+        m_length += length;
+        while (length >= 8) {
+            quint64 word;
+            memcpy(&word, bytes, 8);
+            m_state = (m_state ^ word) * kPrime;
+            m_state ^= m_state >> 32; // 乘法只把位元往高位推，再折回低位
+            bytes += 8;
+            length -= 8;
+        }
+        while (length > 0) {
+            m_state = (m_state ^ *bytes) * kPrime;
+            ++bytes;
+            --length;
+        }
+        return *this;
+    }
+
+    ContentHash &add(const QString &text)
+    {
+        return add(text.utf16(), static_cast<size_t>(text.size()) * sizeof(ushort));
+    }
+
+    ContentHash &add(quint64 value)
+    {
+        return add(&value, sizeof(value));
+    }
+
+    quint64 value() const
+    {
+        // 混入總長度，避免只差在結尾 0 位元組的內容相撞
+        quint64 state = (m_state ^ m_length) * kPrime;
+        return state ^ (state >> 29);
+    }
+
+private:
+
+    static const quint64 kOffsetBasis = Q_UINT64_C(14695981039346656037);
+    static const quint64 kPrime = Q_UINT64_C(1099511628211);
+
+    quint64 m_state;
+    quint64 m_length;
+};
+
+#endif // CONTENTHASH_H
@@ -0,0 +1,238 @@
+#include "documentcache.h"
+#include "contenthash.h"
+#include "maddy/documentformat.h"
+
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QMutexLocker>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+namespace {
+// 快取檔是 maddy::format 的文件：區塊放在標準的 BLOCKS / TEXT 區段，其餘放在應用程式區段
+//   CACHE_INFO 快取版本, 旗標, 內容雜湊, renderKey
+//   LINES      每行一筆 (文字雜湊, 第一個 span, span 數, LineToken 各欄位, 旗標)
+//   SPANS      每個 span 一筆 (起點, 長度, 格式編號)
+// 標示規則或 parser 輸出改變時要提高 kCacheVersion
+enum CacheSection : uint32_t
+{
+    CacheInfoSection = maddy::format::USER_SECTION,
+    LinesSection,
+    SpansSection
+};
+
+const quint32 kCacheVersion = 4;
+const char kFileSuffix[] = ".mdcache";
+
+const size_t kCacheInfoSize = 24;
+const size_t kLineRecordSize = 40;
+const size_t kSpanRecordSize = 12;
+
+const quint32 kHasBlocks = 0x1;
+
+const quint32 kLineHasSpans = 0x1;
+const quint32 kLineDegraded = 0x2;
+const quint32 kLineKnown = 0x4;
+
+std::string writeDocument(quint64 contentHash, const CachedDocument &document)
+{
+    using namespace maddy::format;
+
+    std::string info;
+    AppendUint32(info, kCacheVersion);
+    AppendUint32(info, document.blocks ? kHasBlocks : 0);
+    AppendUint64(info, contentHash);
+    AppendUint64(info, document.renderKey);
+
+    std::string lines;
+    std::string spans;
+    lines.reserve(static_cast<size_t>(document.lines.size()) * kLineRecordSize);
+    quint32 firstSpan = 0;
+    for (const CachedLine &line : document.lines) {
+        quint32 flags = 0;
+        flags |= line.hasSpans ? kLineHasSpans : 0;
+        flags |= line.degraded ? kLineDegraded : 0;
+        flags |= line.lineToken.isKnown ? kLineKnown : 0;
+        AppendUint64(lines, line.textHash);
+        AppendUint32(lines, firstSpan);
+        AppendUint32(lines, static_cast<quint32>(line.spans.size()));
+        AppendUint32(lines, line.lineToken.startingParsers);
+        AppendUint32(lines, line.lineToken.indentation);
+        AppendUint32(lines, line.lineToken.headlineLevel);
+        AppendUint32(lines, line.lineToken.markerLength);
+        AppendUint32(lines, line.lineToken.listItem);
+        AppendUint32(lines, flags);
+        firstSpan += static_cast<quint32>(line.spans.size());
+
+        for (const HighlightSpan &span : line.spans) {
+            AppendUint32(spans, static_cast<quint32>(span.start));
+            AppendUint32(spans, static_cast<quint32>(span.length));
+            AppendUint32(spans, static_cast<quint32>(span.formatId));
+        }
+    }
+
+    maddy::DocumentWriter writer;
+    if (document.blocks) {
+        writer.SetBlocks(*document.blocks);
+    }
+    writer.AddSection(CacheInfoSection, std::move(info));
+    writer.AddSection(LinesSection, std::move(lines));
+    writer.AddSection(SpansSection, std::move(spans));
+    return writer.Write();
+}
+
+// maddy::DocumentView 已檢查過區段範圍；這裡只需檢查應用程式區段內的位移
+bool readDocument(const uchar *data, qint64 size, quint64 contentHash, CachedDocument &document)
+{
+    using namespace maddy::format;
+
+    maddy::DocumentView view(data, static_cast<size_t>(size));
+    const char *info = nullptr;
+    const char *lineRecords = nullptr;
+    const char *spanRecords = nullptr;
+    size_t infoSize = 0;
+    size_t linesSize = 0;
+    size_t spansSize = 0;
+    if (!view.IsValid()
+        || !view.Section(CacheInfoSection, info, infoSize) || infoSize != kCacheInfoSize
+        || !view.Section(LinesSection, lineRecords, linesSize) || linesSize % kLineRecordSize != 0
+        || !view.Section(SpansSection, spanRecords, spansSize) || spansSize % kSpanRecordSize != 0
+        || ReadUint32(info) != kCacheVersion || ReadUint64(info + 8) != contentHash) {
+        return false;
+    }
+
+    const size_t lineCount = linesSize / kLineRecordSize;
+    const size_t spanCount = spansSize / kSpanRecordSize;
+    QVector<CachedLine> lines(static_cast<int>(lineCount));
+    for (size_t i = 0; i < lineCount; ++i) {
+        const char *record = lineRecords + i * kLineRecordSize;
+        const quint32 firstSpan = ReadUint32(record + 8);
+        const quint32 lineSpanCount = ReadUint32(record + 12);
+        const quint32 listItem = ReadUint32(record + 32);
+        const quint32 lineFlags = ReadUint32(record + 36);
+        if (firstSpan > spanCount || lineSpanCount > spanCount - firstSpan || listItem > maddy::types::ORDERED_LIST_ITEM) {
+            return false;
+        }
+
+        CachedLine &line = lines[static_cast<int>(i)];
+        line.textHash = ReadUint64(record);
+        line.hasSpans = (lineFlags & kLineHasSpans) != 0;
+        line.degraded = (lineFlags & kLineDegraded) != 0;
+        line.lineToken.isKnown = (lineFlags & kLineKnown) != 0;
+        line.lineToken.startingParsers = ReadUint32(record + 16);
+        line.lineToken.indentation = ReadUint32(record + 20);
+        line.lineToken.headlineLevel = ReadUint32(record + 24);
+        line.lineToken.markerLength = ReadUint32(record + 28);
+        line.lineToken.listItem = static_cast<maddy::types::LIST_ITEM_TYPE>(listItem);
+
+        line.spans.resize(static_cast<int>(lineSpanCount));
+        for (quint32 j = 0; j < lineSpanCount; ++j) {
+            const char *span = spanRecords + (firstSpan + j) * kSpanRecordSize;
+            HighlightSpan &target = line.spans[static_cast<int>(j)];
+            target.start = static_cast<qint32>(ReadUint32(span));
+            target.length = static_cast<qint32>(ReadUint32(span + 4));
+            target.formatId = static_cast<qint32>(ReadUint32(span + 8));
+            if (target.formatId < 0 || target.formatId >= FormatCount) {
+                return false;
+            }
+        }
+    }
+
+    document.renderKey = ReadUint64(info + 16);
+    document.blocks = (ReadUint32(info + 4) & kHasBlocks)
+                      ? std::make_shared<const std::vector<maddy::ParsedBlock>>(view.ToParsedBlocks())
+                      : RenderCache::Blocks();
+    document.lines = lines;
+    return true;
+}
+}
+
+DocumentCache::DocumentCache(const QString &directory, qint64 maxBytes)
+    : m_directory(directory)
+    , m_maxBytes(maxBytes)
+{
+}
+
+QString DocumentCache::defaultDirectory()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/documents";
+}
+
+QString DocumentCache::entryPath(const QString &filePath) const
+{
+    // 每個檔案只有一個快取檔，內容改變後的新結果直接覆蓋舊的
+    const quint64 pathHash = ContentHash().add(QFileInfo(filePath).absoluteFilePath()).value();
+    return m_directory + "/" + QString::number(pathHash, 16) + kFileSuffix;
+}
+
+bool DocumentCache::load(const QString &filePath, quint64 contentHash, CachedDocument &document) const
+{
+    const QString path = entryPath(filePath);
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    const qint64 size = file.size();
+    const uchar *data = size > 0 ? file.map(0, size) : nullptr;
+    if (!data) {
+        return false;
+    }
+    const bool ok = readDocument(data, size, contentHash, document);
+    file.unmap(const_cast<uchar *>(data));
+    file.close();
+
+    // 以修改時間記錄最後使用時間，淘汰時保留最近開啟過的文件
+    if (ok) {
+        QFile touched(path);
+        if (touched.open(QIODevice::Append)) {
+            touched.setFileTime(QDateTime::currentDateTime(), QFileDevice::FileModificationTime);
+        }
+    }
+    return ok;
+}
+
+bool DocumentCache::store(const QString &filePath, quint64 contentHash, const CachedDocument &document)
+{
+    const std::string buffer = writeDocument(contentHash, document);
+    const qint64 size = static_cast<qint64>(buffer.size());
+    if (size > m_maxBytes) {
+        return false;
+    }
+
+    QMutexLocker locker(&m_mutex);
+    if (!QDir().mkpath(m_directory)) {
+        return false;
+    }
+
+    // QSaveFile 先寫入暫存檔再取代，寫到一半的快取檔不會被讀到
+    QSaveFile file(entryPath(filePath));
+    if (!file.open(QIODevice::WriteOnly) || file.write(buffer.data(), size) != size || !file.commit()) {
+        return false;
+    }
+    evict();
+    return true;
+}
+
+void DocumentCache::setMaxBytes(qint64 maxBytes)
+{
+    QMutexLocker locker(&m_mutex);
+    m_maxBytes = maxBytes;
+    evict();
+}
+
+void DocumentCache::evict()
+{
+    // 由新到舊累計，超過上限之後的快取檔全部刪除
+    const QFileInfoList entries = QDir(m_directory).entryInfoList(QStringList() << QString("*") + kFileSuffix,
+                                                                  QDir::Files, QDir::Time);
+    qint64 totalBytes = 0;
+    for (const QFileInfo &entry : entries) {
+        totalBytes += entry.size();
+        if (totalBytes > m_maxBytes) {
+            QFile::remove(entry.absoluteFilePath());
+        }
+    }
+}
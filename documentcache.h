@@ -0,0 +1,50 @@
+// documentcache.h
+
+#ifndef DOCUMENTCACHE_H
+#define DOCUMENTCACHE_H
+
+#include <QMutex>
+#include <QString>
+#include <QVector>
+
+#include "highlighttokenizer.h"
+#include "rendercache.h"
+
+// 一份文件的預覽轉換結果與編輯區標示結果
+struct CachedDocument
+{
+    quint64 renderKey = 0;      // blocks 在 RenderCache 中的鍵
+    RenderCache::Blocks blocks; // 空指標表示沒有預覽結果
+    QVector<CachedLine> lines;  // 依行號排列
+};
+
+// 磁碟上的文件快取：以檔案路徑決定快取檔，內容雜湊不符時視為未命中。
+// 快取檔是 maddy::format 的二進位文件，以 QFile::map 直接讀取；
+// 總大小超過上限時依最後使用時間 (修改時間) 刪除最舊的快取檔。
+// load 與 store 可在背景執行緒呼叫
+class DocumentCache
+{
+public:
+
+    explicit DocumentCache(const QString &directory, qint64 maxBytes = 256 * 1024 * 1024);
+
+    // 系統快取目錄下的 documents 子目錄
+    static QString defaultDirectory();
+
+    // 快取檔不存在、內容雜湊不符或格式不正確時回傳 false
+    bool load(const QString &filePath, quint64 contentHash, CachedDocument &document) const;
+    bool store(const QString &filePath, quint64 contentHash, const CachedDocument &document);
+
+    void setMaxBytes(qint64 maxBytes);
+
+private:
+
+    QString entryPath(const QString &filePath) const;
+    void evict();
+
+    QString m_directory;
+    qint64 m_maxBytes;
+    QMutex m_mutex; // store 與淘汰不可同時進行
+};
+
+#endif // DOCUMENTCACHE_H
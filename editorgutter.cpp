@@ -0,0 +1,53 @@
+#include "editorgutter.h"
+#include "markdownhighlighter.h"
+
+#include <QAbstractTextDocumentLayout>
+#include <QPainter>
+#include <QScrollBar>
+#include <QTextBlock>
+#include <QTextEdit>
+
+namespace {
+const int kGutterWidth = 6;
+}
+
+EditorGutter::EditorGutter(QTextEdit *editor, QWidget *parent)
+    : QWidget(parent)
+    , m_editor(editor)
+{
+    setFixedWidth(kGutterWidth);
+    setToolTip("橘色標記：此行過長或過於複雜，只套用了簡易標示");
+
+    // 捲動或內容變動時重新繪製標記
+    connect(editor->verticalScrollBar(), &QScrollBar::valueChanged, this, [this]() { update(); });
+    connect(editor->document(), &QTextDocument::contentsChanged, this, [this]() { update(); });
+}
+
+QSize EditorGutter::sizeHint() const
+{
+    return QSize(kGutterWidth, 0);
+}
+
+void EditorGutter::paintEvent(QPaintEvent * /*event*/)
+{
+    QPainter painter(this);
+    QAbstractTextDocumentLayout *layout = m_editor->document()->documentLayout();
+    int scroll = m_editor->verticalScrollBar()->value();
+    int offset = m_editor->viewport()->y();
+
+    // 只走訪目前可見的區塊
+    QTextBlock block = m_editor->cursorForPosition(QPoint(0, 0)).block();
+    while (block.isValid()) {
+        QRectF rect = layout->blockBoundingRect(block);
+        int top = qRound(rect.top()) - scroll + offset;
+        if (top > height()) {
+            break;
+        }
+
+        MarkdownBlockData *data = static_cast<MarkdownBlockData *>(block.userData());
+        if (data && data->isDegraded) {
+            painter.fillRect(0, top, kGutterWidth, qRound(rect.height()), QColor(255, 165, 0));
+        }
+        block = block.next();
+    }
+}
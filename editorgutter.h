@@ -0,0 +1,30 @@
+// editorgutter.h
+
+#ifndef EDITORGUTTER_H
+#define EDITORGUTTER_H
+
+#include <QWidget>
+
+class QTextEdit;
+
+// 編輯區左側的窄邊欄：標示因超出長度或時間上限而只做了簡易標示的行
+class EditorGutter : public QWidget
+{
+    Q_OBJECT
+
+public:
+
+    explicit EditorGutter(QTextEdit *editor, QWidget *parent = nullptr);
+
+    QSize sizeHint() const override;
+
+protected:
+
+    void paintEvent(QPaintEvent *event) override;
+
+private:
+
+    QTextEdit *m_editor;
+};
+
+#endif // EDITORGUTTER_H
@@ -0,0 +1,84 @@
+#include "executorpanel.h"
+#include "taskexecutor.h"
+
+#include <QHeaderView>
+#include <QLabel>
+#include <QTableWidget>
+#include <QTimer>
+#include <QVBoxLayout>
+
+namespace {
+const int kRefreshIntervalMs = 500;
+}
+
+ExecutorPanel::ExecutorPanel(QWidget *parent)
+    : QWidget(parent, Qt::Tool)
+    , m_summary(new QLabel(this))
+    , m_table(new QTableWidget(0, 6, this))
+    , m_refreshTimer(new QTimer(this))
+{
+    setWindowTitle("背景工作狀態");
+    resize(560, 320);
+
+    m_table->setHorizontalHeaderLabels({"類別", "提交", "完成", "取消", "平均 (ms)", "最長 (ms)"});
+    m_table->horizontalHeader()->setSectionResizeMode(0, QHeaderView::Stretch);
+    m_table->verticalHeader()->hide();
+    m_table->setEditTriggers(QAbstractItemView::NoEditTriggers);
+
+    QVBoxLayout *layout = new QVBoxLayout(this);
+    layout->addWidget(m_summary);
+    layout->addWidget(m_table);
+
+    // 只在面板開啟時更新
+    m_refreshTimer->setInterval(kRefreshIntervalMs);
+    connect(m_refreshTimer, &QTimer::timeout, this, &ExecutorPanel::refresh);
+}
+
+void ExecutorPanel::addStatsSource(const QString &name, std::function<QString()> source)
+{
+    m_statsSources.append(qMakePair(name, source));
+}
+
+void ExecutorPanel::showEvent(QShowEvent *event)
+{
+    QWidget::showEvent(event);
+    refresh();
+    m_refreshTimer->start();
+}
+
+void ExecutorPanel::hideEvent(QHideEvent *event)
+{
+    QWidget::hideEvent(event);
+    m_refreshTimer->stop();
+}
+
+void ExecutorPanel::refresh()
+{
+    TaskExecutor::Stats stats = TaskExecutor::instance()->takeStats();
+
+    QString summary = QString("排隊中：互動 %1 / 可見 %2 / 背景 %3　執行中：%4 / %5 執行緒　使用率：%6%")
+                      .arg(stats.queued[TaskExecutor::Interactive])
+                      .arg(stats.queued[TaskExecutor::Visible])
+                      .arg(stats.queued[TaskExecutor::Background])
+                      .arg(stats.running)
+                      .arg(stats.maxThreads)
+                      .arg(qRound(stats.utilization * 100));
+    for (const QPair<QString, std::function<QString()>> &source : m_statsSources) {
+        summary += QString("\n%1：%2").arg(source.first, source.second());
+    }
+    m_summary->setText(summary);
+
+    m_table->setRowCount(stats.categories.size());
+    int row = 0;
+    for (auto it = stats.categories.constBegin(); it != stats.categories.constEnd(); ++it, ++row) {
+        const TaskExecutor::CategoryStats &category = it.value();
+        int finished = category.completed + category.cancelled;
+        double averageMs = finished > 0 ? category.totalNs / 1e6 / finished : 0.0;
+        m_table->setItem(row, 0, new QTableWidgetItem(it.key()));
+        m_table->setItem(row, 1, new QTableWidgetItem(QString::number(category.submitted)));
+        m_table->setItem(row, 2, new QTableWidgetItem(QString::number(category.completed)));
+        m_table->setItem(row, 3, new QTableWidgetItem(QString::number(category.cancelled)));
+        m_table->setItem(row, 4, new QTableWidgetItem(QString::number(averageMs, 'f', 2)));
+        m_table->setItem(row, 5, new QTableWidgetItem(QString::number(category.maxNs / 1e6, 'f', 2)));
+    }
+}
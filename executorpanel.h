@@ -0,0 +1,45 @@
+// executorpanel.h
+
+#ifndef EXECUTORPANEL_H
+#define EXECUTORPANEL_H
+
+#include <QWidget>
+#include <QList>
+#include <QPair>
+
+#include <functional>
+
+class QLabel;
+class QTableWidget;
+class QTimer;
+
+// 除錯用面板：顯示 TaskExecutor 各優先順序的排隊數、執行緒使用率與各類工作的耗時
+class ExecutorPanel : public QWidget
+{
+    Q_OBJECT
+
+public:
+
+    explicit ExecutorPanel(QWidget *parent = nullptr);
+
+    // 額外顯示的統計 (例如快取命中率)，每次更新時呼叫 source 取得文字
+    void addStatsSource(const QString &name, std::function<QString()> source);
+
+protected:
+
+    void showEvent(QShowEvent *event) override;
+    void hideEvent(QHideEvent *event) override;
+
+private slots:
+
+    void refresh();
+
+private:
+
+    QLabel *m_summary;
+    QTableWidget *m_table;
+    QTimer *m_refreshTimer;
+    QList<QPair<QString, std::function<QString()>>> m_statsSources;
+};
+
+#endif // EXECUTORPANEL_H
@@ -0,0 +1,141 @@
+#include "highlighttokenizer.h"
+#include "contenthash.h"
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QHash>
+
+HighlightTokenizer::HighlightTokenizer()
+{
+    // 規則順序與原本 highlighter 相同，後面的規則會覆蓋前面的格式；
+    // 標題、程式碼分隔符、清單與引用改由與預覽共用的 maddy::LineTokenizer 判斷
+    m_rules.append({QRegularExpression(), FormatHeading1});
+    m_rules.append({QRegularExpression(), FormatHeading2});
+    m_rules.append({QRegularExpression(), FormatHeading3});
+    m_rules.append({QRegularExpression(), FormatHeading4});
+    m_rules.append({QRegularExpression(), FormatHeading5});
+    m_rules.append({QRegularExpression(), FormatHeading6});
+    m_rules.append({QRegularExpression("(\\*\\*|__)(.*?)\\1"), FormatBold});
+    m_rules.append({QRegularExpression("(?<!\\*)\\*(?!\\*|_)(.*?)(?<!_)\\*(?!\\*)|(?<!_)_{(?!_)(.*?)(?<!_)_{(?!_)"), FormatItalic});
+    m_rules.append({QRegularExpression(), FormatCodeFence});
+    m_rules.append({QRegularExpression(), FormatList});
+    m_rules.append({QRegularExpression("`([^`].*?)`"), FormatInlineCode});
+    m_rules.append({QRegularExpression(), FormatBlockquote});
+    m_rules.append({QRegularExpression("\\[([^\\]]+)\\]"), FormatLinkText});
+    m_rules.append({QRegularExpression("\\(([^\\)]+)\\)"), FormatLinkUrl});
+}
+
+void HighlightTokenizer::warmUp() const
+{
+    QElapsedTimer timer;
+    timer.start();
+    for (const TokenRule &rule : m_rules) {
+        if (!rule.pattern.pattern().isEmpty()) {
+            rule.pattern.optimize();
+        }
+    }
+    qDebug() << "startup: highlighter warm-up" << timer.nsecsElapsed() / 1000 << "us";
+}
+
+TokenizedBlock HighlightTokenizer::tokenize(const BlockSnapshot &snapshot, int maxLength, int maxMilliseconds) const
+{
+    TokenizedBlock result;
+    result.requestId = snapshot.requestId;
+    result.revision = snapshot.revision;
+    result.hash = qHash(snapshot.text);
+    result.textHash = ContentHash().add(snapshot.text).value();
+    result.degraded = false;
+
+    const QString &text = snapshot.text;
+    const int length = text.length();
+    result.lineToken = maddy::LineTokenizer::Tokenize(text.utf16(), static_cast<size_t>(length));
+
+    // 過長的行 (例如貼上的壓縮 JSON) 直接只做結構性標示
+    if (maxLength > 0 && length > maxLength) {
+        result.degraded = true;
+        tokenizeStructure(result.lineToken, length, result.spans);
+        return result;
+    }
+
+    QElapsedTimer elapsed;
+    elapsed.start();
+
+    for (const TokenRule &rule : m_rules) {
+        if (rule.pattern.pattern().isEmpty()) {
+            appendStructuralSpan(rule.formatId, result.lineToken, length, result.spans);
+            continue;
+        }
+
+        QRegularExpressionMatchIterator matchIterator = rule.pattern.globalMatch(text);
+        while (matchIterator.hasNext()) {
+            QRegularExpressionMatch match = matchIterator.next();
+            result.spans.append({match.capturedStart(), match.capturedLength(), rule.formatId});
+
+            // 超過時間上限就放棄完整標示
+            if (maxMilliseconds > 0 && elapsed.elapsed() > maxMilliseconds) {
+                result.degraded = true;
+                result.spans.clear();
+                tokenizeStructure(result.lineToken, length, result.spans);
+                return result;
+            }
+        }
+    }
+    return result;
+}
+
+void HighlightTokenizer::tokenizeStructure(const maddy::LineToken &token, int textLength, QVector<HighlightSpan> &spans)
+{
+    appendStructuralSpan(FormatHeading1 + static_cast<int>(token.headlineLevel) - 1, token, textLength, spans);
+    appendStructuralSpan(FormatCodeFence, token, textLength, spans);
+    appendStructuralSpan(FormatList, token, textLength, spans);
+}
+
+void HighlightTokenizer::appendStructuralSpan(int formatId, const maddy::LineToken &token, int textLength,
+                                              QVector<HighlightSpan> &spans)
+{
+    switch (formatId) {
+    case FormatHeading1:
+    case FormatHeading2:
+    case FormatHeading3:
+    case FormatHeading4:
+    case FormatHeading5:
+    case FormatHeading6:
+        if (token.headlineLevel == static_cast<uint32_t>(formatId - FormatHeading1 + 1)) {
+            spans.append({0, textLength, formatId});
+        }
+        break;
+    case FormatCodeFence:
+        if (token.startingParsers & maddy::types::CODE_BLOCK_PARSER) {
+            spans.append({0, 3, formatId});
+        }
+        break;
+    case FormatList:
+        // 有序清單沿用原本的行為標示整行，無序清單只標示符號
+        if (token.listItem == maddy::types::ORDERED_LIST_ITEM) {
+            spans.append({0, textLength, formatId});
+        } else if (token.listItem == maddy::types::UNORDERED_LIST_ITEM) {
+            spans.append({0, static_cast<int>(token.markerLength), formatId});
+        }
+        break;
+    case FormatBlockquote:
+        if (token.startingParsers & maddy::types::QUOTE_PARSER) {
+            spans.append({0, textLength, formatId});
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+QVector<TokenizedBlock> HighlightTokenizer::tokenizeBlocks(const QVector<BlockSnapshot> &snapshots, int maxLength,
+                                                           int maxMilliseconds, const CancellationToken &token) const
+{
+    QVector<TokenizedBlock> results;
+    results.reserve(snapshots.size());
+    for (const BlockSnapshot &snapshot : snapshots) {
+        if (token.isCancelled()) {
+            break;
+        }
+        results.append(tokenize(snapshot, maxLength, maxMilliseconds));
+    }
+    return results;
+}
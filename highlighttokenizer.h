@@ -0,0 +1,106 @@
+// highlighttokenizer.h
+
+#ifndef HIGHLIGHTTOKENIZER_H
+#define HIGHLIGHTTOKENIZER_H
+
+#include <QRegularExpression>
+#include <QString>
+#include <QVector>
+
+#include "maddy/linetokenizer.h"
+#include "taskexecutor.h"
+
+// 格式編號：對應 MarkdownHighlighter 的格式表，順序即套用順序
+enum HighlightFormat
+{
+    FormatHeading1,
+    FormatHeading2,
+    FormatHeading3,
+    FormatHeading4,
+    FormatHeading5,
+    FormatHeading6,
+    FormatBold,
+    FormatItalic,
+    FormatCodeFence,
+    FormatList,
+    FormatInlineCode,
+    FormatBlockquote,
+    FormatLinkText,
+    FormatLinkUrl,
+    FormatCount
+};
+
+// 一段標示結果：(起點, 長度, 格式編號)
+struct HighlightSpan
+{
+    int start;
+    int length;
+    int formatId;
+};
+
+// 送往背景執行緒的區塊快照
+struct BlockSnapshot
+{
+    quint64 requestId;
+    int revision;
+    QString text;
+};
+
+// 背景執行緒回傳的標示結果
+struct TokenizedBlock
+{
+    quint64 requestId;
+    int revision;
+    uint hash;
+    quint64 textHash;            // 文字的 ContentHash，預覽重用 lineToken 前逐行比對
+    bool degraded;
+    maddy::LineToken lineToken;  // 與預覽端 maddy::Parser 共用的行結構分類
+    QVector<HighlightSpan> spans;
+};
+
+// 保存在磁碟快取中的單行標示結果；textHash 是該行文字的 ContentHash，套用前逐行比對
+struct CachedLine
+{
+    quint64 textHash = 0;
+    bool hasSpans = false;
+    bool degraded = false;
+    maddy::LineToken lineToken;
+    QVector<HighlightSpan> spans;
+};
+
+// 在背景執行緒將區塊文字切成 span 陣列，不接觸任何 QTextDocument 物件。
+// 所有方法皆為 const，可同時在多個 TaskExecutor 工作中使用
+class HighlightTokenizer
+{
+public:
+
+    HighlightTokenizer();
+
+    // 單一區塊的斷詞；超過長度或時間上限時只回傳結構性 span
+    TokenizedBlock tokenize(const BlockSnapshot &snapshot, int maxLength, int maxMilliseconds) const;
+
+    // 只做標題、程式碼分隔符與清單前綴的快速判斷
+    static void tokenizeStructure(const maddy::LineToken &token, int textLength, QVector<HighlightSpan> &spans);
+
+    // 在背景執行緒預先編譯 (含 JIT) 所有規則，避免第一次標示時才編譯
+    void warmUp() const;
+
+    // 依序斷詞；取消後剩下的區塊不再處理
+    QVector<TokenizedBlock> tokenizeBlocks(const QVector<BlockSnapshot> &snapshots, int maxLength,
+                                           int maxMilliseconds, const CancellationToken &token) const;
+
+private:
+
+    static void appendStructuralSpan(int formatId, const maddy::LineToken &token, int textLength,
+                                     QVector<HighlightSpan> &spans);
+
+    // pattern 為空的規則代表結構性格式，由 maddy::LineTokenizer 的結果決定
+    struct TokenRule
+    {
+        QRegularExpression pattern;
+        int formatId;
+    };
+    QVector<TokenRule> m_rules;
+};
+
+#endif // HIGHLIGHTTOKENIZER_H
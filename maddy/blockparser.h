@@ -96,6 +96,27 @@ public:
     this->result << line;
   }
 
+  /**
+   * AddVerbatim
+   *
+   * Blocks that copy their lines without parsing them (code, LaTeX) take
+   * their whole body at once instead of line by line. `markdown` starts at
+   * the line after the one added last. Nothing is taken, if the line ending
+   * the block is not in `markdown`; that line itself is always left for
+   * `AddLine`.
+   *
+   * @method
+   * @param {const char*} markdown
+   * @param {size_t} size
+   * @param {size_t&} lineCount receives the count of taken lines
+   * @return {size_t} count of taken bytes
+   */
+  virtual size_t AddVerbatim(const char*, size_t, size_t& lineCount)
+  {
+    lineCount = 0;
+    return 0;
+  }
+
   /**
    * IsFinished
    *
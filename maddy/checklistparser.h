@@ -7,10 +7,10 @@
 // -----------------------------------------------------------------------------
 
 #include <functional>
-#include <regex>
 #include <string>
 
-#include "maddy/blockparser.h"
+#include "maddy/linematcher.h"
+#include "maddy/listparser.h"
 
 // -----------------------------------------------------------------------------
 
@@ -23,7 +23,7 @@ namespace maddy {
  *
  * @class
  */
-class ChecklistParser : public BlockParser
+class ChecklistParser : public ListParser
 {
 public:
   /**
@@ -33,15 +33,20 @@ public:
    * @param {std::function<void(std::string&)>} parseLineCallback
    * @param {std::function<std::shared_ptr<BlockParser>(const std::string&
    * line)>} getBlockParserForLineCallback
+   * @param {uint32_t} nestedParsers lists that may be nested
    */
   ChecklistParser(
     std::function<void(std::string&)> parseLineCallback,
     std::function<std::shared_ptr<BlockParser>(const std::string& line)>
-      getBlockParserForLineCallback
+      getBlockParserForLineCallback,
+    uint32_t nestedParsers = types::CHECKLIST_PARSER
   )
-    : BlockParser(parseLineCallback, getBlockParserForLineCallback)
-    , isStarted(false)
-    , isFinished(false)
+    : ListParser(
+        parseLineCallback,
+        getBlockParserForLineCallback,
+        types::CHECKLIST_PARSER,
+        nestedParsers
+      )
   {}
 
   /**
@@ -55,71 +60,8 @@ public:
    */
   static bool IsStartingLine(const std::string& line)
   {
-    static std::regex re(R"(^- \[[x| ]\] .*)");
-    return std::regex_match(line, re);
+    return patterns::ChecklistStart::Match(line);
   }
-
-  /**
-   * IsFinished
-   *
-   * @method
-   * @return {bool}
-   */
-  bool IsFinished() const override { return this->isFinished; }
-
-protected:
-  bool isInlineBlockAllowed() const override { return true; }
-
-  bool isLineParserAllowed() const override { return true; }
-
-  void parseBlock(std::string& line) override
-  {
-    bool isStartOfNewListItem = IsStartingLine(line);
-    uint32_t indentation = getIndentationWidth(line);
-
-    static std::regex lineRegex("^(- )");
-    line = std::regex_replace(line, lineRegex, "");
-
-    static std::regex emptyBoxRegex(R"(^\[ \])");
-    static std::string emptyBoxReplacement = "<input type=\"checkbox\"/>";
-    line = std::regex_replace(line, emptyBoxRegex, emptyBoxReplacement);
-
-    static std::regex boxRegex(R"(^\[x\])");
-    static std::string boxReplacement =
-      "<input type=\"checkbox\" checked=\"checked\"/>";
-    line = std::regex_replace(line, boxRegex, boxReplacement);
-
-    if (!this->isStarted)
-    {
-      line = "<ul class=\"checklist\"><li><label>" + line;
-      this->isStarted = true;
-      return;
-    }
-
-    if (indentation >= 2)
-    {
-      line = line.substr(2);
-      return;
-    }
-
-    if (line.empty() ||
-        line.find("</label></li><li><label>") != std::string::npos ||
-        line.find("</label></li></ul>") != std::string::npos)
-    {
-      line = "</label></li></ul>" + line;
-      this->isFinished = true;
-      return;
-    }
-
-    if (isStartOfNewListItem)
-    {
-      line = "</label></li><li><label>" + line;
-    }
-  }
-
-private:
-  bool isStarted;
-  bool isFinished;
 }; // class ChecklistParser
 
 // -----------------------------------------------------------------------------
@@ -6,11 +6,14 @@
 
 // -----------------------------------------------------------------------------
 
+#include <algorithm>
 #include <functional>
-#include <regex>
 #include <string>
+#include <string.h>
 
 #include "maddy/blockparser.h"
+#include "maddy/htmlescaper.h"
+#include "maddy/linematcher.h"
 
 // -----------------------------------------------------------------------------
 
@@ -75,8 +78,7 @@ public:
    */
   static bool IsStartingLine(const std::string& line)
   {
-    static std::regex re("^(?:`){3}(.*)$");
-    return std::regex_match(line, re);
+    return patterns::CodeBlockStart::Match(line);
   }
 
   /**
@@ -87,6 +89,39 @@ public:
    */
   bool IsFinished() const override { return this->isFinished; }
 
+  /**
+   * AddVerbatim
+   *
+   * Escapes everything up to the closing ```` ``` ```` in one go.
+   *
+   * @method
+   * @param {const char*} markdown
+   * @param {size_t} size
+   * @param {size_t&} lineCount
+   * @return {size_t}
+   */
+  size_t AddVerbatim(const char* markdown, size_t size, size_t& lineCount)
+    override
+  {
+    lineCount = 0;
+    if (!this->isStarted)
+    {
+      return 0;
+    }
+
+    const size_t end = findClosingLine(markdown, size);
+    if (end == size)
+    {
+      return 0;
+    }
+
+    std::string body;
+    HtmlEscaper::Append(body, markdown, end);
+    this->result << body;
+    lineCount = static_cast<size_t>(std::count(markdown, markdown + end, '\n'));
+    return end;
+  }
+
 protected:
   bool isInlineBlockAllowed() const override { return false; }
 
@@ -113,18 +148,44 @@ protected:
     }
     else if (!this->isStarted && line.substr(0, 3) == "```")
     {
-      line = "<pre class=\"" + line.substr(3) + "\"><code>";
+      std::string language = line.substr(3);
+      HtmlEscaper::Escape(language);
+      line = "<pre class=\"" + language + "\"><code>";
       this->isStarted = true;
       this->isFinished = false;
       return;
     }
 
+    HtmlEscaper::Escape(line);
     line += "\n";
   }
 
 private:
   bool isStarted;
   bool isFinished;
+
+  // start of the first line that is exactly ```` ``` ```` or `size`
+  static size_t findClosingLine(const char* markdown, size_t size)
+  {
+    size_t pos = 0;
+    while (pos < size)
+    {
+      if (size - pos >= 3 && memcmp(markdown + pos, "```", 3) == 0 &&
+          (size - pos == 3 || markdown[pos + 3] == '\n'))
+      {
+        return pos;
+      }
+
+      const void* lineEnd = memchr(markdown + pos, '\n', size - pos);
+      if (!lineEnd)
+      {
+        break;
+      }
+      pos =
+        static_cast<size_t>(static_cast<const char*>(lineEnd) - markdown) + 1;
+    }
+    return size;
+  }
 }; // class CodeBlockParser
 
 // -----------------------------------------------------------------------------
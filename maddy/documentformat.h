@@ -0,0 +1,428 @@
+/*
+ * This project is licensed under the MIT license. For more information see the
+ * LICENSE file.
+ */
+#pragma once
+
+// -----------------------------------------------------------------------------
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "maddy/parser.h"
+
+// -----------------------------------------------------------------------------
+
+namespace maddy {
+
+// -----------------------------------------------------------------------------
+
+/**
+ * format
+ *
+ * Binary layout of a parsed document, so it can be stored or passed to
+ * another process and used without parsing the markdown again.
+ *
+ * All integers are little-endian, all offsets are in bytes from the start of
+ * the document and every section starts 8-byte aligned, so a memory mapped
+ * file can be read in place.
+ *
+ *   header         magic "MDDY", major, minor, section count, total size
+ *   section table  (id, offset, size) per section
+ *   sections
+ *
+ * Standard sections:
+ *
+ *   BLOCKS_SECTION  one record per `ParsedBlock`:
+ *                   html offset into TEXT_SECTION (u64), html length (u32),
+ *                   first line (u32), line count (u32), reserved (u32)
+ *   TEXT_SECTION    the html of all blocks
+ *
+ * A reader accepts every minor version of its major version. Minor versions
+ * may only add sections; ids from `USER_SECTION` on are free for
+ * applications.
+ */
+namespace format {
+
+// clang-format off
+enum SECTION_ID : uint32_t
+{
+  BLOCKS_SECTION = 1,
+  TEXT_SECTION   = 2,
+
+  USER_SECTION   = 0x10000,
+};
+// clang-format on
+
+static const char MAGIC[4] = {'M', 'D', 'D', 'Y'};
+static const uint16_t MAJOR_VERSION = 1;
+static const uint16_t MINOR_VERSION = 0;
+
+static const size_t HEADER_SIZE = 24;
+static const size_t SECTION_ENTRY_SIZE = 24;
+static const size_t BLOCK_RECORD_SIZE = 24;
+
+inline void AppendUint16(std::string& out, uint16_t value)
+{
+  out.push_back(static_cast<char>(value & 0xff));
+  out.push_back(static_cast<char>(value >> 8));
+}
+
+inline void AppendUint32(std::string& out, uint32_t value)
+{
+  AppendUint16(out, static_cast<uint16_t>(value & 0xffff));
+  AppendUint16(out, static_cast<uint16_t>(value >> 16));
+}
+
+inline void AppendUint64(std::string& out, uint64_t value)
+{
+  AppendUint32(out, static_cast<uint32_t>(value & 0xffffffff));
+  AppendUint32(out, static_cast<uint32_t>(value >> 32));
+}
+
+inline uint16_t ReadUint16(const char* data)
+{
+  const unsigned char* bytes = reinterpret_cast<const unsigned char*>(data);
+  return static_cast<uint16_t>(bytes[0] | (bytes[1] << 8));
+}
+
+inline uint32_t ReadUint32(const char* data)
+{
+  return static_cast<uint32_t>(ReadUint16(data)) |
+         (static_cast<uint32_t>(ReadUint16(data + 2)) << 16);
+}
+
+inline uint64_t ReadUint64(const char* data)
+{
+  return static_cast<uint64_t>(ReadUint32(data)) |
+         (static_cast<uint64_t>(ReadUint32(data + 4)) << 32);
+}
+
+} // namespace format
+
+// -----------------------------------------------------------------------------
+
+/**
+ * DocumentWriter
+ *
+ * Collects the sections of a document and writes them in the `format`
+ * layout.
+ *
+ * @class
+ */
+class DocumentWriter
+{
+public:
+  /**
+   * SetBlocks
+   *
+   * Writes the blocks into `BLOCKS_SECTION` and `TEXT_SECTION`.
+   *
+   * @method
+   * @param {const std::vector<ParsedBlock>&} blocks
+   */
+  void SetBlocks(const std::vector<ParsedBlock>& blocks)
+  {
+    std::string records;
+    std::string text;
+    records.reserve(blocks.size() * format::BLOCK_RECORD_SIZE);
+
+    for (const ParsedBlock& block : blocks)
+    {
+      format::AppendUint64(records, text.size());
+      format::AppendUint32(records, static_cast<uint32_t>(block.html.size()));
+      format::AppendUint32(records, static_cast<uint32_t>(block.firstLine));
+      format::AppendUint32(records, static_cast<uint32_t>(block.lineCount));
+      format::AppendUint32(records, 0);
+      text += block.html;
+    }
+
+    this->AddSection(format::BLOCKS_SECTION, std::move(records));
+    this->AddSection(format::TEXT_SECTION, std::move(text));
+  }
+
+  /**
+   * AddSection
+   *
+   * A section with the same id replaces the previous one.
+   *
+   * @method
+   * @param {uint32_t} id
+   * @param {std::string} data
+   */
+  void AddSection(uint32_t id, std::string data)
+  {
+    for (auto& section : this->sections)
+    {
+      if (section.first == id)
+      {
+        section.second = std::move(data);
+        return;
+      }
+    }
+    this->sections.emplace_back(id, std::move(data));
+  }
+
+  /**
+   * Write
+   *
+   * @method
+   * @return {std::string} the whole document
+   */
+  std::string Write() const
+  {
+    const size_t tableEnd =
+      format::HEADER_SIZE + this->sections.size() * format::SECTION_ENTRY_SIZE;
+
+    size_t totalSize = align(tableEnd);
+    for (const auto& section : this->sections)
+    {
+      totalSize = align(totalSize + section.second.size());
+    }
+
+    std::string out;
+    out.reserve(totalSize);
+    out.append(format::MAGIC, sizeof(format::MAGIC));
+    format::AppendUint16(out, format::MAJOR_VERSION);
+    format::AppendUint16(out, format::MINOR_VERSION);
+    format::AppendUint32(out, static_cast<uint32_t>(this->sections.size()));
+    format::AppendUint32(out, 0);
+    format::AppendUint64(out, totalSize);
+
+    size_t offset = align(tableEnd);
+    for (const auto& section : this->sections)
+    {
+      format::AppendUint32(out, section.first);
+      format::AppendUint32(out, 0);
+      format::AppendUint64(out, offset);
+      format::AppendUint64(out, section.second.size());
+      offset = align(offset + section.second.size());
+    }
+
+    for (const auto& section : this->sections)
+    {
+      out.resize(align(out.size()), '\0');
+      out += section.second;
+    }
+    out.resize(totalSize, '\0');
+
+    return out;
+  }
+
+private:
+  std::vector<std::pair<uint32_t, std::string>> sections;
+
+  static size_t align(size_t offset) { return (offset + 7) & ~size_t(7); }
+}; // class DocumentWriter
+
+// -----------------------------------------------------------------------------
+
+/**
+ * DocumentView
+ *
+ * Reads a document in the `format` layout in place, e.g. from a memory mapped
+ * file. The data has to outlive the view.
+ *
+ * All offsets and sizes are checked once in the constructor, so a truncated
+ * or corrupt document is only invalid and the accessors need no checks.
+ *
+ * @class
+ */
+class DocumentView
+{
+public:
+  /**
+   * Block
+   *
+   * A `ParsedBlock` without the copy of its html.
+   *
+   * @class
+   */
+  struct Block
+  {
+    const char* html;
+    size_t htmlLength;
+    size_t firstLine;
+    size_t lineCount;
+  };
+
+  /**
+   * ctor
+   *
+   * @method
+   * @param {const void*} data
+   * @param {size_t} size
+   */
+  DocumentView(const void* data, size_t size)
+    : data(static_cast<const char*>(data))
+    , size(size)
+    , valid(false)
+    , sectionCount(0)
+    , blocks(nullptr)
+    , blockCount(0)
+    , text(nullptr)
+    , textSize(0)
+  {
+    this->valid = this->validate();
+  }
+
+  bool IsValid() const { return this->valid; }
+
+  /**
+   * MinorVersion
+   *
+   * @method
+   * @return {uint16_t} tells which optional sections the writer knew
+   */
+  uint16_t MinorVersion() const
+  {
+    return this->valid ? format::ReadUint16(this->data + 6) : 0;
+  }
+
+  size_t BlockCount() const { return this->blockCount; }
+
+  /**
+   * GetBlock
+   *
+   * @method
+   * @param {size_t} index < BlockCount()
+   * @return {Block}
+   */
+  Block GetBlock(size_t index) const
+  {
+    const char* record = this->blocks + index * format::BLOCK_RECORD_SIZE;
+    return Block{
+      this->text + format::ReadUint64(record),
+      format::ReadUint32(record + 8),
+      format::ReadUint32(record + 12),
+      format::ReadUint32(record + 16)
+    };
+  }
+
+  /**
+   * ToParsedBlocks
+   *
+   * Copies all blocks, e.g. to hand them to code that expects the result of
+   * `Parser::ParseBlocks`.
+   *
+   * @method
+   * @return {std::vector<ParsedBlock>}
+   */
+  std::vector<ParsedBlock> ToParsedBlocks() const
+  {
+    std::vector<ParsedBlock> result;
+    result.reserve(this->blockCount);
+    for (size_t i = 0; i < this->blockCount; ++i)
+    {
+      const Block block = this->GetBlock(i);
+      result.push_back(ParsedBlock{
+        std::string(block.html, block.htmlLength),
+        block.firstLine,
+        block.lineCount
+      });
+    }
+    return result;
+  }
+
+  /**
+   * Section
+   *
+   * @method
+   * @param {uint32_t} id
+   * @param {const char*&} sectionData
+   * @param {size_t&} sectionSize
+   * @return {bool} false, if the document has no such section
+   */
+  bool Section(uint32_t id, const char*& sectionData, size_t& sectionSize) const
+  {
+    for (size_t i = 0; i < this->sectionCount; ++i)
+    {
+      const char* entry =
+        this->data + format::HEADER_SIZE + i * format::SECTION_ENTRY_SIZE;
+      if (format::ReadUint32(entry) == id)
+      {
+        sectionData = this->data + format::ReadUint64(entry + 8);
+        sectionSize = static_cast<size_t>(format::ReadUint64(entry + 16));
+        return true;
+      }
+    }
+    return false;
+  }
+
+private:
+  const char* data;
+  size_t size;
+  bool valid;
+  size_t sectionCount;
+  const char* blocks;
+  size_t blockCount;
+  const char* text;
+  size_t textSize;
+
+  bool validate()
+  {
+    if (!this->data || this->size < format::HEADER_SIZE ||
+        memcmp(this->data, format::MAGIC, sizeof(format::MAGIC)) != 0 ||
+        format::ReadUint16(this->data + 4) != format::MAJOR_VERSION ||
+        format::ReadUint64(this->data + 16) != this->size)
+    {
+      return false;
+    }
+
+    this->sectionCount = format::ReadUint32(this->data + 8);
+    if (this->sectionCount >
+        (this->size - format::HEADER_SIZE) / format::SECTION_ENTRY_SIZE)
+    {
+      return false;
+    }
+
+    for (size_t i = 0; i < this->sectionCount; ++i)
+    {
+      const char* entry =
+        this->data + format::HEADER_SIZE + i * format::SECTION_ENTRY_SIZE;
+      const uint64_t offset = format::ReadUint64(entry + 8);
+      const uint64_t sectionSize = format::ReadUint64(entry + 16);
+      if (offset > this->size || sectionSize > this->size - offset)
+      {
+        return false;
+      }
+    }
+
+    // a document without blocks is valid, e.g. one with only user sections
+    const char* records = nullptr;
+    size_t recordsSize = 0;
+    if (!this->Section(format::BLOCKS_SECTION, records, recordsSize))
+    {
+      return true;
+    }
+    if (recordsSize % format::BLOCK_RECORD_SIZE != 0 ||
+        !this->Section(format::TEXT_SECTION, this->text, this->textSize))
+    {
+      return false;
+    }
+
+    this->blocks = records;
+    this->blockCount = recordsSize / format::BLOCK_RECORD_SIZE;
+    for (size_t i = 0; i < this->blockCount; ++i)
+    {
+      const char* record = this->blocks + i * format::BLOCK_RECORD_SIZE;
+      const uint64_t offset = format::ReadUint64(record);
+      const uint32_t length = format::ReadUint32(record + 8);
+      if (offset > this->textSize || length > this->textSize - offset)
+      {
+        this->blockCount = 0;
+        return false;
+      }
+    }
+
+    return true;
+  }
+}; // class DocumentView
+
+// -----------------------------------------------------------------------------
+
+} // namespace maddy
@@ -7,10 +7,12 @@
 // -----------------------------------------------------------------------------
 
 #include <functional>
-#include <regex>
 #include <string>
 
 #include "maddy/blockparser.h"
+#include "maddy/htmlescaper.h"
+#include "maddy/linematcher.h"
+#include "maddy/outline.h"
 
 // -----------------------------------------------------------------------------
 
@@ -43,6 +45,9 @@ namespace maddy {
  * <h6>Headline 6</h6>
  * ```
  *
+ * With an `Outline` every headline also gets an id (`<h1 id="headline-1">`)
+ * and is recorded in the outline.
+ *
  * @class
  */
 class HeadlineParser : public BlockParser
@@ -55,15 +60,19 @@ public:
    * @param {std::function<void(std::string&)>} parseLineCallback
    * @param {std::function<std::shared_ptr<BlockParser>(const std::string&
    * line)>} getBlockParserForLineCallback
+   * @param {bool} isInlineParserAllowed
+   * @param {Outline*} outline may be null, has to outlive the parser
    */
   HeadlineParser(
     std::function<void(std::string&)> parseLineCallback,
     std::function<std::shared_ptr<BlockParser>(const std::string& line)>
       getBlockParserForLineCallback,
-    bool isInlineParserAllowed = true
+    bool isInlineParserAllowed = true,
+    Outline* outline = nullptr
   )
     : BlockParser(parseLineCallback, getBlockParserForLineCallback)
     , isInlineParserAllowed(isInlineParserAllowed)
+    , outline(outline)
   {}
 
   /**
@@ -77,8 +86,7 @@ public:
    */
   static bool IsStartingLine(const std::string& line)
   {
-    static std::regex re("^(?:#){1,6} (.*)");
-    return std::regex_match(line, re);
+    return patterns::HeadlineStart::Match(line);
   }
 
   /**
@@ -102,31 +110,56 @@ protected:
 
   void parseBlock(std::string& line) override
   {
-    static std::vector<std::regex> hlRegex = {
-      std::regex("^# (.*)"),
-      std::regex("^(?:#){2} (.*)"),
-      std::regex("^(?:#){3} (.*)"),
-      std::regex("^(?:#){4} (.*)"),
-      std::regex("^(?:#){5} (.*)"),
-      std::regex("^(?:#){6} (.*)")
-    };
-    static std::vector<std::string> hlReplacement = {
-      "<h1>$1</h1>",
-      "<h2>$1</h2>",
-      "<h3>$1</h3>",
-      "<h4>$1</h4>",
-      "<h5>$1</h5>",
-      "<h6>$1</h6>"
-    };
-
-    for (uint8_t i = 0; i < 6; ++i)
+    size_t level = 0;
+    while (level < line.size() && line[level] == '#')
+    {
+      ++level;
+    }
+    if (level < 1 || level > 6 || level >= line.size() || line[level] != ' ')
+    {
+      return;
+    }
+
+    // like the `.*` of the former regular expressions, the text ends before a
+    // line break and the rest of the line stays behind the closing tag
+    const size_t textBegin = level + 1;
+    size_t textEnd = line.find_first_of("\r\n", textBegin);
+    if (textEnd == std::string::npos)
+    {
+      textEnd = line.size();
+    }
+
+    const char levelDigit = static_cast<char>('0' + level);
+    std::string html;
+    html.reserve(line.size() + 16);
+    html += "<h";
+    html += levelDigit;
+    if (this->outline)
     {
-      line = std::regex_replace(line, hlRegex[i], hlReplacement[i]);
+      const Heading& heading = this->outline->Add(
+        static_cast<uint32_t>(level),
+        line.data() + textBegin,
+        textEnd - textBegin
+      );
+      // the line parsers run after this, `_` of the id must not end up as
+      // italic
+      html += " id=\"";
+      HtmlEscaper::Append(html, heading.id.data(), heading.id.size(), true);
+      html += '"';
     }
+    html += '>';
+    html.append(line, textBegin, textEnd - textBegin);
+    html += "</h";
+    html += levelDigit;
+    html += '>';
+    html.append(line, textEnd, std::string::npos);
+
+    line.swap(html);
   }
 
 private:
   bool isInlineParserAllowed;
+  Outline* outline;
 }; // class HeadlineParser
 
 // -----------------------------------------------------------------------------
@@ -11,6 +11,7 @@
 #include <string>
 
 #include "maddy/blockparser.h"
+#include "maddy/linematcher.h"
 
 // -----------------------------------------------------------------------------
 
@@ -58,8 +59,7 @@ public:
    */
   static bool IsStartingLine(const std::string& line)
   {
-    static std::regex re("^---$");
-    return std::regex_match(line, re);
+    return patterns::HorizontalLine::Match(line);
   }
 
   /**
@@ -0,0 +1,247 @@
+/*
+ * This project is licensed under the MIT license. For more information see the
+ * LICENSE file.
+ */
+#pragma once
+
+// -----------------------------------------------------------------------------
+
+#include <stddef.h>
+#include <string>
+
+#if defined(__SSE2__) || defined(_M_X64) || \
+  (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define MADDY_HTMLESCAPER_SSE2 1
+#include <emmintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+// -----------------------------------------------------------------------------
+
+namespace maddy {
+
+// -----------------------------------------------------------------------------
+
+/**
+ * HtmlEscaper
+ *
+ * Escapes `&`, `<`, `>` and `"` for text that has to show up literally.
+ *
+ * Most text has none of them, so it is scanned 16 bytes at a time (SSE2, if
+ * available) and copied in runs between the special characters. Text without
+ * any special character is not copied at all.
+ *
+ * @class
+ */
+class HtmlEscaper
+{
+public:
+  /**
+   * Escape
+   *
+   * @method
+   * @param {std::string&} text is escaped in place
+   */
+  static void Escape(std::string& text) { escape(text, false); }
+
+  /**
+   * EscapeCode
+   *
+   * Like `Escape`, but also writes the markers of the inline parsers (`*`,
+   * `_`, `~`, `[`, `]`, `(`, `)`, `!`) as character references, so that the
+   * content of an inline code span is left alone by the parsers running after
+   * the `InlineCodeParser`.
+   *
+   * @method
+   * @param {std::string&} text is escaped in place
+   */
+  static void EscapeCode(std::string& text) { escape(text, true); }
+
+  /**
+   * Append
+   *
+   * @method
+   * @param {std::string&} out
+   * @param {const char*} data
+   * @param {size_t} length
+   * @param {bool} isCode escape like `EscapeCode`
+   */
+  static void Append(
+    std::string& out, const char* data, size_t length, bool isCode = false
+  )
+  {
+    out.reserve(out.size() + length + length / 16);
+
+    size_t pos = 0;
+    while (pos < length)
+    {
+      const size_t special = findSpecial(data, pos, length, isCode);
+      out.append(data + pos, special - pos);
+      if (special == length)
+      {
+        break;
+      }
+      out += replacement(data[special]);
+      pos = special + 1;
+    }
+  }
+
+private:
+  static void escape(std::string& text, bool isCode)
+  {
+    const size_t first = findSpecial(text.data(), 0, text.size(), isCode);
+    if (first == text.size())
+    {
+      return;
+    }
+
+    std::string escaped;
+    escaped.reserve(text.size() + text.size() / 16);
+    escaped.append(text, 0, first);
+    Append(escaped, text.data() + first, text.size() - first, isCode);
+    text.swap(escaped);
+  }
+
+  static bool isSpecial(char c, bool isCode)
+  {
+    switch (c)
+    {
+      case '&':
+      case '<':
+      case '>':
+      case '"':
+        return true;
+      case '*':
+      case '_':
+      case '~':
+      case '[':
+      case ']':
+      case '(':
+      case ')':
+      case '!':
+        return isCode;
+      default:
+        return false;
+    }
+  }
+
+  static const char* replacement(char c)
+  {
+    switch (c)
+    {
+      case '&':
+        return "&amp;";
+      case '<':
+        return "&lt;";
+      case '>':
+        return "&gt;";
+      case '"':
+        return "&quot;";
+      case '*':
+        return "&#42;";
+      case '_':
+        return "&#95;";
+      case '~':
+        return "&#126;";
+      case '[':
+        return "&#91;";
+      case ']':
+        return "&#93;";
+      case '(':
+        return "&#40;";
+      case ')':
+        return "&#41;";
+      case '!':
+        return "&#33;";
+      default:
+        return "";
+    }
+  }
+
+  // position of the first special character at or after `pos` or `length`
+  static size_t findSpecial(
+    const char* data, size_t pos, size_t length, bool isCode
+  )
+  {
+#ifdef MADDY_HTMLESCAPER_SSE2
+    const __m128i amp = _mm_set1_epi8('&');
+    const __m128i lt = _mm_set1_epi8('<');
+    const __m128i gt = _mm_set1_epi8('>');
+    const __m128i quot = _mm_set1_epi8('"');
+
+    for (; pos + 16 <= length; pos += 16)
+    {
+      const __m128i chunk =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + pos));
+      __m128i hits = _mm_or_si128(
+        _mm_or_si128(_mm_cmpeq_epi8(chunk, amp), _mm_cmpeq_epi8(chunk, lt)),
+        _mm_or_si128(_mm_cmpeq_epi8(chunk, gt), _mm_cmpeq_epi8(chunk, quot))
+      );
+      if (isCode)
+      {
+        hits = _mm_or_si128(hits, codeMarkers(chunk));
+      }
+
+      const int mask = _mm_movemask_epi8(hits);
+      if (mask != 0)
+      {
+        return pos + lowestBit(static_cast<unsigned int>(mask));
+      }
+    }
+#endif
+
+    for (; pos < length; ++pos)
+    {
+      if (isSpecial(data[pos], isCode))
+      {
+        return pos;
+      }
+    }
+    return length;
+  }
+
+#ifdef MADDY_HTMLESCAPER_SSE2
+  static __m128i codeMarkers(__m128i chunk)
+  {
+    return _mm_or_si128(
+      _mm_or_si128(
+        _mm_or_si128(
+          _mm_cmpeq_epi8(chunk, _mm_set1_epi8('*')),
+          _mm_cmpeq_epi8(chunk, _mm_set1_epi8('_'))
+        ),
+        _mm_or_si128(
+          _mm_cmpeq_epi8(chunk, _mm_set1_epi8('~')),
+          _mm_cmpeq_epi8(chunk, _mm_set1_epi8('!'))
+        )
+      ),
+      _mm_or_si128(
+        _mm_or_si128(
+          _mm_cmpeq_epi8(chunk, _mm_set1_epi8('[')),
+          _mm_cmpeq_epi8(chunk, _mm_set1_epi8(']'))
+        ),
+        _mm_or_si128(
+          _mm_cmpeq_epi8(chunk, _mm_set1_epi8('(')),
+          _mm_cmpeq_epi8(chunk, _mm_set1_epi8(')'))
+        )
+      )
+    );
+  }
+
+  static size_t lowestBit(unsigned int mask)
+  {
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward(&index, mask);
+    return index;
+#else
+    return static_cast<size_t>(__builtin_ctz(mask));
+#endif
+  }
+#endif
+}; // class HtmlEscaper
+
+// -----------------------------------------------------------------------------
+
+} // namespace maddy
@@ -32,7 +32,7 @@ public:
    *
    * From Markdown: `![text](http://example.com/a.png)`
    *
-   * To HTML: `<img src="http://example.com/a.png" alt="text"/>`
+   * To HTML: `<img src="http://example.com/a.png" alt="text" loading="lazy"/>`
    *
    * @method
    * @param {std::string&} line The line to interpret
@@ -41,7 +41,8 @@ public:
   void Parse(std::string& line) override
   {
     static std::regex re(R"(\!\[([^\]]*)\]\(([^\]]*)\))");
-    static std::string replacement = "<img src=\"$2\" alt=\"$1\"/>";
+    static std::string replacement =
+      "<img src=\"$2\" alt=\"$1\" loading=\"lazy\"/>";
 
     line = std::regex_replace(line, re, replacement);
   }
@@ -6,9 +6,9 @@
 
 // -----------------------------------------------------------------------------
 
-#include <regex>
 #include <string>
 
+#include "maddy/htmlescaper.h"
 #include "maddy/lineparser.h"
 
 // -----------------------------------------------------------------------------
@@ -32,16 +32,44 @@ public:
    *
    * To HTML: `text <code>some code</code>`
    *
+   * The code is escaped with `HtmlEscaper::EscapeCode`, so `<` shows up as
+   * `<` and the other inline parsers do not touch it.
+   *
    * @method
    * @param {std::string&} line The line to interpret
    * @return {void}
    */
   void Parse(std::string& line) override
   {
-    static std::regex re("`([^`]*)`");
-    static std::string replacement = "<code>$1</code>";
+    size_t open = line.find('`');
+    size_t close = open != std::string::npos ? line.find('`', open + 1)
+                                             : std::string::npos;
+    if (close == std::string::npos)
+    {
+      return;
+    }
+
+    std::string result;
+    result.reserve(line.size() + 16);
+    size_t pos = 0;
+
+    while (close != std::string::npos)
+    {
+      result.append(line, pos, open - pos);
+      result += "<code>";
+      HtmlEscaper::Append(
+        result, line.data() + open + 1, close - open - 1, true
+      );
+      result += "</code>";
+
+      pos = close + 1;
+      open = line.find('`', pos);
+      close = open != std::string::npos ? line.find('`', open + 1)
+                                        : std::string::npos;
+    }
 
-    line = std::regex_replace(line, re, replacement);
+    result.append(line, pos, std::string::npos);
+    line.swap(result);
   }
 }; // class InlineCodeParser
 
@@ -0,0 +1,228 @@
+/*
+ * This project is licensed under the MIT license. For more information see the
+ * LICENSE file.
+ */
+#pragma once
+
+// -----------------------------------------------------------------------------
+
+#include <functional>
+#include <list>
+#include <mutex>
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <unordered_map>
+
+// -----------------------------------------------------------------------------
+
+namespace maddy {
+
+// -----------------------------------------------------------------------------
+
+/**
+ * InlineMemo
+ *
+ * LRU memo for the inline stage of the `Parser`. It maps a line together with
+ * the enabled inline parsers to the line after all `LineParser` ran on it, so
+ * repeated lines (table rows, list items, a document parsed again after a
+ * small edit) skip the regular expressions.
+ *
+ * One memo may be shared by several `Parser` instances, also on different
+ * threads.
+ *
+ * @class
+ */
+class InlineMemo
+{
+public:
+  /**
+   * ctor
+   *
+   * @method
+   * @param {size_t} maxBytes memory budget for lines and results
+   */
+  explicit InlineMemo(size_t maxBytes = 4 * 1024 * 1024)
+    : maxBytes(maxBytes)
+    , usedBytes(0)
+    , hits(0)
+    , misses(0)
+  {}
+
+  /**
+   * Find
+   *
+   * @method
+   * @param {const std::string&} line
+   * @param {uint32_t} inlineParsers `PARSER_TYPE` bits of the inline parsers
+   * @param {std::string&} result receives the transformed line on a hit
+   * @return {bool} true, if the line was found
+   */
+  bool Find(
+    const std::string& line, uint32_t inlineParsers, std::string& result
+  )
+  {
+    const size_t key = makeKey(line, inlineParsers);
+    std::lock_guard<std::mutex> lock(this->mutex);
+
+    auto found = this->index.find(key);
+    if (found == this->index.end() ||
+        found->second->inlineParsers != inlineParsers ||
+        found->second->line != line)
+    {
+      ++this->misses;
+      return false;
+    }
+
+    // move to the front, the back is evicted first
+    this->entries.splice(this->entries.begin(), this->entries, found->second);
+    result = found->second->result;
+    ++this->hits;
+    return true;
+  }
+
+  /**
+   * Insert
+   *
+   * @method
+   * @param {const std::string&} line
+   * @param {uint32_t} inlineParsers
+   * @param {const std::string&} result
+   */
+  void Insert(
+    const std::string& line, uint32_t inlineParsers, const std::string& result
+  )
+  {
+    const size_t cost = entryCost(line, result);
+    if (cost > this->maxBytes)
+    {
+      return;
+    }
+
+    const size_t key = makeKey(line, inlineParsers);
+    std::lock_guard<std::mutex> lock(this->mutex);
+
+    // on a hash collision the newer line wins
+    auto found = this->index.find(key);
+    if (found != this->index.end())
+    {
+      this->remove(found->second);
+    }
+
+    this->entries.push_front(Entry{key, inlineParsers, line, result});
+    this->index[key] = this->entries.begin();
+    this->usedBytes += cost;
+    this->evict();
+  }
+
+  /**
+   * SetMaxBytes
+   *
+   * @method
+   * @param {size_t} maxBytes
+   */
+  void SetMaxBytes(size_t maxBytes)
+  {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    this->maxBytes = maxBytes;
+    this->evict();
+  }
+
+  /**
+   * Clear
+   *
+   * Drops all entries and resets the statistics.
+   *
+   * @method
+   */
+  void Clear()
+  {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    this->entries.clear();
+    this->index.clear();
+    this->usedBytes = 0;
+    this->hits = 0;
+    this->misses = 0;
+  }
+
+  size_t Hits() const
+  {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    return this->hits;
+  }
+
+  size_t Misses() const
+  {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    return this->misses;
+  }
+
+  size_t UsedBytes() const
+  {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    return this->usedBytes;
+  }
+
+  /**
+   * HitRate
+   *
+   * @method
+   * @return {double} 0 - 1
+   */
+  double HitRate() const
+  {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    const size_t total = this->hits + this->misses;
+    return total > 0 ? static_cast<double>(this->hits) / total : 0.0;
+  }
+
+private:
+  struct Entry
+  {
+    size_t key;
+    uint32_t inlineParsers;
+    std::string line;
+    std::string result;
+  };
+
+  typedef std::list<Entry>::iterator EntryIterator;
+
+  mutable std::mutex mutex;
+  std::list<Entry> entries;
+  std::unordered_map<size_t, EntryIterator> index;
+  size_t maxBytes;
+  size_t usedBytes;
+  size_t hits;
+  size_t misses;
+
+  static size_t makeKey(const std::string& line, uint32_t inlineParsers)
+  {
+    return std::hash<std::string>()(line) ^
+           (static_cast<size_t>(inlineParsers) * 0x9e3779b9u);
+  }
+
+  // the strings plus a rough estimate for the list and map nodes
+  static size_t entryCost(const std::string& line, const std::string& result)
+  {
+    return line.size() + result.size() + sizeof(Entry) + 64;
+  }
+
+  void remove(EntryIterator entry)
+  {
+    this->usedBytes -= entryCost(entry->line, entry->result);
+    this->index.erase(entry->key);
+    this->entries.erase(entry);
+  }
+
+  void evict()
+  {
+    while (this->usedBytes > this->maxBytes && !this->entries.empty())
+    {
+      this->remove(std::prev(this->entries.end()));
+    }
+  }
+}; // class InlineMemo
+
+// -----------------------------------------------------------------------------
+
+} // namespace maddy
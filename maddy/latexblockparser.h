@@ -7,10 +7,12 @@
 // -----------------------------------------------------------------------------
 
 #include <functional>
-#include <regex>
 #include <string>
+#include <string.h>
 
 #include "maddy/blockparser.h"
+#include "maddy/htmlescaper.h"
+#include "maddy/linematcher.h"
 
 // -----------------------------------------------------------------------------
 
@@ -79,8 +81,7 @@ public:
    */
   static bool IsStartingLine(const std::string& line)
   {
-    static std::regex re(R"(^(?:\$){2}(.*)$)");
-    return std::regex_match(line, re);
+    return patterns::LatexBlockStart::Match(line);
   }
 
   /**
@@ -91,6 +92,56 @@ public:
    */
   bool IsFinished() const override { return this->isFinished; }
 
+  /**
+   * AddVerbatim
+   *
+   * Escapes everything up to the line ending with `$$` in one go.
+   *
+   * @method
+   * @param {const char*} markdown
+   * @param {size_t} size
+   * @param {size_t&} lineCount
+   * @return {size_t}
+   */
+  size_t AddVerbatim(const char* markdown, size_t size, size_t& lineCount)
+    override
+  {
+    lineCount = 0;
+    if (!this->isStarted || this->isFinished)
+    {
+      return 0;
+    }
+
+    size_t pos = 0;
+    while (pos < size)
+    {
+      const void* found = memchr(markdown + pos, '\n', size - pos);
+      const size_t lineEnd =
+        found ? static_cast<size_t>(static_cast<const char*>(found) - markdown)
+              : size;
+      if (lineEnd - pos > 1 && markdown[lineEnd - 1] == '$' &&
+          markdown[lineEnd - 2] == '$')
+      {
+        break;
+      }
+
+      ++lineCount;
+      pos = lineEnd + 1;
+    }
+
+    // the block does not end in `markdown`
+    if (pos >= size)
+    {
+      lineCount = 0;
+      return 0;
+    }
+
+    std::string body;
+    HtmlEscaper::Append(body, markdown, pos);
+    this->result << body;
+    return pos;
+  }
+
 protected:
   bool isInlineBlockAllowed() const override { return false; }
 
@@ -111,6 +162,7 @@ protected:
       this->isStarted = false;
     }
 
+    HtmlEscaper::Escape(line);
     line += "\n";
   }
 
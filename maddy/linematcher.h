@@ -0,0 +1,329 @@
+/*
+ * This project is licensed under the MIT license. For more information see the
+ * LICENSE file.
+ */
+#pragma once
+
+// -----------------------------------------------------------------------------
+
+#include <stddef.h>
+#include <string>
+
+// -----------------------------------------------------------------------------
+
+namespace maddy {
+
+// -----------------------------------------------------------------------------
+
+/**
+ * match
+ *
+ * Building blocks for fixed line patterns. A pattern is a type, e.g.
+ * `Line<Seq<Repeat<Char<'#'>, 1, 6>, Char<' '>, AnyToEnd>>` for
+ * `^(?:#){1,6} (.*)`, so it is put together at compile time and matching it
+ * needs neither a regex compilation nor an allocation.
+ *
+ * Every element advances `pos` only if it matches. `Repeat` is greedy and
+ * never gives characters back, so it may only be followed by an element that
+ * cannot match the repeated character.
+ */
+namespace match {
+
+namespace detail {
+
+template <typename CharT>
+constexpr bool isOneOf(CharT)
+{
+  return false;
+}
+
+template <typename CharT, typename... Rest>
+constexpr bool isOneOf(CharT c, char first, Rest... rest)
+{
+  return c == static_cast<CharT>(first) || isOneOf(c, rest...);
+}
+
+} // namespace detail
+
+/**
+ * Char
+ *
+ * Matches exactly the character `C`.
+ *
+ * @class
+ */
+template <char C>
+struct Char
+{
+  template <typename CharT>
+  static constexpr bool Match(const CharT* line, size_t length, size_t& pos)
+  {
+    if (pos < length && line[pos] == static_cast<CharT>(C))
+    {
+      ++pos;
+      return true;
+    }
+    return false;
+  }
+}; // struct Char
+
+/**
+ * AnyOf
+ *
+ * Matches one of the characters `Cs`, like `[x| ]`.
+ *
+ * @class
+ */
+template <char... Cs>
+struct AnyOf
+{
+  template <typename CharT>
+  static constexpr bool Match(const CharT* line, size_t length, size_t& pos)
+  {
+    if (pos < length && detail::isOneOf(line[pos], Cs...))
+    {
+      ++pos;
+      return true;
+    }
+    return false;
+  }
+}; // struct AnyOf
+
+/**
+ * Repeat
+ *
+ * Matches `Element` at least `Min` and at most `Max` times, like `{Min,Max}`.
+ *
+ * @class
+ */
+template <typename Element, size_t Min, size_t Max>
+struct Repeat
+{
+  template <typename CharT>
+  static constexpr bool Match(const CharT* line, size_t length, size_t& pos)
+  {
+    size_t count = 0;
+    while (count < Max && Element::Match(line, length, pos))
+    {
+      ++count;
+    }
+    return count >= Min;
+  }
+}; // struct Repeat
+
+/**
+ * Seq
+ *
+ * Matches all `Elements` one after another.
+ *
+ * @class
+ */
+template <typename... Elements>
+struct Seq;
+
+template <>
+struct Seq<>
+{
+  template <typename CharT>
+  static constexpr bool Match(const CharT*, size_t, size_t&)
+  {
+    return true;
+  }
+}; // struct Seq
+
+template <typename Element, typename... Rest>
+struct Seq<Element, Rest...>
+{
+  template <typename CharT>
+  static constexpr bool Match(const CharT* line, size_t length, size_t& pos)
+  {
+    return Element::Match(line, length, pos) &&
+           Seq<Rest...>::Match(line, length, pos);
+  }
+}; // struct Seq
+
+/**
+ * Str
+ *
+ * Matches the characters `Cs` in this order.
+ *
+ * @class
+ */
+template <char... Cs>
+struct Str : Seq<Char<Cs>...>
+{}; // struct Str
+
+/**
+ * AnyToEnd
+ *
+ * `.*` up to the end of the line. Like `.` of the regular expressions it
+ * replaces, it does not match line breaks.
+ *
+ * @class
+ */
+struct AnyToEnd
+{
+  template <typename CharT>
+  static constexpr bool Match(const CharT* line, size_t length, size_t& pos)
+  {
+    for (; pos < length; ++pos)
+    {
+      if (line[pos] == static_cast<CharT>('\n') ||
+          line[pos] == static_cast<CharT>('\r'))
+      {
+        return false;
+      }
+    }
+    return true;
+  }
+}; // struct AnyToEnd
+
+/**
+ * Line
+ *
+ * The whole line has to match `Pattern`, like `std::regex_match`.
+ *
+ * @class
+ */
+template <typename Pattern>
+struct Line
+{
+  template <typename CharT>
+  static constexpr bool Match(const CharT* line, size_t length)
+  {
+    size_t pos = 0;
+    return Pattern::Match(line, length, pos) && pos == length;
+  }
+
+  static bool Match(const std::string& line)
+  {
+    return Match(line.data(), line.size());
+  }
+}; // struct Line
+
+} // namespace match
+
+// -----------------------------------------------------------------------------
+
+/**
+ * patterns
+ *
+ * Starting lines of the block parsers. Shared by their `IsStartingLine` and
+ * the `LineTokenizer`.
+ */
+namespace patterns {
+
+namespace detail {
+
+// the patterns are checked against string literals at compile time below
+template <typename Pattern, size_t N>
+constexpr bool matches(const char (&line)[N])
+{
+  return Pattern::Match(line, N - 1);
+}
+
+} // namespace detail
+
+// ^- \[[x| ]\] .*
+using ChecklistStart = match::Line<match::Seq<
+  match::Str<'-', ' ', '['>,
+  match::AnyOf<'x', '|', ' '>,
+  match::Str<']', ' '>,
+  match::AnyToEnd>>;
+
+static_assert(detail::matches<ChecklistStart>("- [ ] a"), "");
+static_assert(detail::matches<ChecklistStart>("- [x] a"), "");
+static_assert(detail::matches<ChecklistStart>("- [|] a"), "");
+static_assert(detail::matches<ChecklistStart>("- [x] "), "");
+static_assert(!detail::matches<ChecklistStart>("- [X] a"), "");
+static_assert(!detail::matches<ChecklistStart>("- [x]a"), "");
+static_assert(!detail::matches<ChecklistStart>("- [x]"), "");
+static_assert(!detail::matches<ChecklistStart>("-  [x] a"), "");
+static_assert(!detail::matches<ChecklistStart>(" - [x] a"), "");
+static_assert(!detail::matches<ChecklistStart>("- [x] a\r"), "");
+static_assert(!detail::matches<ChecklistStart>("- [x] a\nb"), "");
+
+// ^(?:`){3}(.*)$
+using CodeBlockStart =
+  match::Line<match::Seq<match::Str<'`', '`', '`'>, match::AnyToEnd>>;
+
+static_assert(detail::matches<CodeBlockStart>("```"), "");
+static_assert(detail::matches<CodeBlockStart>("```cpp"), "");
+static_assert(detail::matches<CodeBlockStart>("````"), "");
+static_assert(!detail::matches<CodeBlockStart>("``"), "");
+static_assert(!detail::matches<CodeBlockStart>(" ```"), "");
+static_assert(!detail::matches<CodeBlockStart>("```\r"), "");
+static_assert(!detail::matches<CodeBlockStart>("```\n"), "");
+
+// ^(?:#){1,6} (.*)
+using HeadlineStart = match::Line<match::Seq<
+  match::Repeat<match::Char<'#'>, 1, 6>,
+  match::Char<' '>,
+  match::AnyToEnd>>;
+
+static_assert(detail::matches<HeadlineStart>("# a"), "");
+static_assert(detail::matches<HeadlineStart>("###### a"), "");
+static_assert(detail::matches<HeadlineStart>("# "), "");
+static_assert(detail::matches<HeadlineStart>("#  a  "), "");
+static_assert(!detail::matches<HeadlineStart>("####### a"), "");
+static_assert(!detail::matches<HeadlineStart>("#a"), "");
+static_assert(!detail::matches<HeadlineStart>("#"), "");
+static_assert(!detail::matches<HeadlineStart>(" # a"), "");
+static_assert(!detail::matches<HeadlineStart>("# a\r"), "");
+static_assert(!detail::matches<HeadlineStart>("# a\nb"), "");
+
+// ^---$
+using HorizontalLine = match::Line<match::Str<'-', '-', '-'>>;
+
+static_assert(detail::matches<HorizontalLine>("---"), "");
+static_assert(!detail::matches<HorizontalLine>("--"), "");
+static_assert(!detail::matches<HorizontalLine>("----"), "");
+static_assert(!detail::matches<HorizontalLine>(" ---"), "");
+static_assert(!detail::matches<HorizontalLine>("--- "), "");
+static_assert(!detail::matches<HorizontalLine>("---\r"), "");
+static_assert(!detail::matches<HorizontalLine>("---\n"), "");
+
+// ^(?:\$){2}(.*)$
+using LatexBlockStart =
+  match::Line<match::Seq<match::Str<'$', '$'>, match::AnyToEnd>>;
+
+static_assert(detail::matches<LatexBlockStart>("$$"), "");
+static_assert(detail::matches<LatexBlockStart>("$$x^2$$"), "");
+static_assert(!detail::matches<LatexBlockStart>("$"), "");
+static_assert(!detail::matches<LatexBlockStart>(" $$"), "");
+static_assert(!detail::matches<LatexBlockStart>("$$\r"), "");
+static_assert(!detail::matches<LatexBlockStart>("$$\n"), "");
+
+// ^1\. .*
+using OrderedListStart =
+  match::Line<match::Seq<match::Str<'1', '.', ' '>, match::AnyToEnd>>;
+
+static_assert(detail::matches<OrderedListStart>("1. a"), "");
+static_assert(detail::matches<OrderedListStart>("1. "), "");
+static_assert(!detail::matches<OrderedListStart>("2. a"), "");
+static_assert(!detail::matches<OrderedListStart>("10. a"), "");
+static_assert(!detail::matches<OrderedListStart>("1.a"), "");
+static_assert(!detail::matches<OrderedListStart>(" 1. a"), "");
+static_assert(!detail::matches<OrderedListStart>("1. a\r"), "");
+static_assert(!detail::matches<OrderedListStart>("1. a\nb"), "");
+
+// ^[+*-] .*
+using UnorderedListStart = match::Line<
+  match::Seq<match::AnyOf<'+', '*', '-'>, match::Char<' '>, match::AnyToEnd>>;
+
+static_assert(detail::matches<UnorderedListStart>("- a"), "");
+static_assert(detail::matches<UnorderedListStart>("* a"), "");
+static_assert(detail::matches<UnorderedListStart>("+ a"), "");
+static_assert(detail::matches<UnorderedListStart>("- "), "");
+static_assert(!detail::matches<UnorderedListStart>("-a"), "");
+static_assert(!detail::matches<UnorderedListStart>("-"), "");
+static_assert(!detail::matches<UnorderedListStart>(" - a"), "");
+static_assert(!detail::matches<UnorderedListStart>("\t- a"), "");
+static_assert(!detail::matches<UnorderedListStart>("- a\r"), "");
+static_assert(!detail::matches<UnorderedListStart>("- a\nb"), "");
+
+} // namespace patterns
+
+// -----------------------------------------------------------------------------
+
+} // namespace maddy
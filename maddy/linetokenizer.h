@@ -0,0 +1,277 @@
+/*
+ * This project is licensed under the MIT license. For more information see the
+ * LICENSE file.
+ */
+#pragma once
+
+// -----------------------------------------------------------------------------
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+
+#include "maddy/linematcher.h"
+#include "maddy/parserconfig.h"
+
+// -----------------------------------------------------------------------------
+
+namespace maddy {
+
+// -----------------------------------------------------------------------------
+
+namespace types {
+
+/**
+ * LIST_ITEM_TYPE
+ *
+ * Kind of list item marker found at the start of a line
+ */
+enum LIST_ITEM_TYPE : uint8_t
+{
+  NO_LIST_ITEM = 0,
+  UNORDERED_LIST_ITEM,
+  ORDERED_LIST_ITEM
+};
+
+} // namespace types
+
+/**
+ * LineToken
+ *
+ * Structural classification of one markdown line. It only looks at ASCII
+ * characters, so a token computed from the UTF-16 text of the editor is valid
+ * for the UTF-8 text of the parser and vice versa.
+ *
+ * @class
+ */
+struct LineToken
+{
+  /**
+   * false, if the line was not tokenized (e.g. not highlighted yet)
+   */
+  bool isKnown;
+
+  /**
+   * `PARSER_TYPE` bits of every block parser that may start at this line
+   */
+  uint32_t startingParsers;
+
+  /**
+   * count of leading whitespace characters
+   */
+  uint32_t indentation;
+
+  /**
+   * 1 - 6 for a headline, 0 otherwise
+   */
+  uint32_t headlineLevel;
+
+  /**
+   * length of the structural prefix: `# ` of a headline, the fence of a code
+   * block, `>` of a quote or indentation plus marker of a list item
+   */
+  uint32_t markerLength;
+
+  types::LIST_ITEM_TYPE listItem;
+
+  LineToken()
+    : isKnown(false)
+    , startingParsers(types::NONE)
+    , indentation(0)
+    , headlineLevel(0)
+    , markerLength(0)
+    , listItem(types::NO_LIST_ITEM)
+  {}
+}; // struct LineToken
+
+/**
+ * LineTokenizer
+ *
+ * Shared by the editor highlighter and the `Parser` block dispatch, so both
+ * agree on what a line is.
+ *
+ * @class
+ */
+class LineTokenizer
+{
+public:
+  /**
+   * Tokenize
+   *
+   * Works on any character type (`char` for the parser, `ushort` / `QChar`
+   * code units for the editor).
+   *
+   * @method
+   * @param {const CharT*} line
+   * @param {size_t} length
+   * @return {LineToken}
+   */
+  template <typename CharT>
+  static LineToken Tokenize(const CharT* line, size_t length)
+  {
+    LineToken token;
+    token.isKnown = true;
+
+    if (length == 0)
+    {
+      return token;
+    }
+
+    token.startingParsers |= types::PARAGRAPH_PARSER;
+
+    while (token.indentation < length && isSpace(line[token.indentation]))
+    {
+      ++token.indentation;
+    }
+
+    const CharT first = line[0];
+
+    if (first == '`' && patterns::CodeBlockStart::Match(line, length))
+    {
+      token.startingParsers |= types::CODE_BLOCK_PARSER;
+      token.markerLength = 3;
+    }
+    else if (first == '$' && patterns::LatexBlockStart::Match(line, length))
+    {
+      token.startingParsers |= types::LATEX_BLOCK_PARSER;
+      token.markerLength = 2;
+    }
+    else if (first == '#' && patterns::HeadlineStart::Match(line, length))
+    {
+      size_t level = 0;
+      while (line[level] == '#')
+      {
+        ++level;
+      }
+
+      token.startingParsers |= types::HEADLINE_PARSER;
+      token.headlineLevel = static_cast<uint32_t>(level);
+      token.markerLength = static_cast<uint32_t>(level + 1);
+    }
+    else if (first == '>')
+    {
+      token.startingParsers |= types::QUOTE_PARSER;
+      token.markerLength = 1;
+    }
+    else if (first == '<')
+    {
+      token.startingParsers |= types::HTML_PARSER;
+    }
+
+    if (patterns::HorizontalLine::Match(line, length))
+    {
+      token.startingParsers |= types::HORIZONTAL_LINE_PARSER;
+    }
+
+    if (length == 7 && startsWith(line, length, "|table>"))
+    {
+      token.startingParsers |= types::TABLE_PARSER;
+    }
+
+    tokenizeListItem(line, length, token);
+
+    return token;
+  }
+
+  /**
+   * Tokenize
+   *
+   * @method
+   * @param {const std::string&} line
+   * @return {LineToken}
+   */
+  static LineToken Tokenize(const std::string& line)
+  {
+    return Tokenize(line.data(), line.size());
+  }
+
+private:
+  template <typename CharT>
+  static bool isSpace(CharT c)
+  {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\v' || c == '\f' ||
+           c == '\r';
+  }
+
+  template <typename CharT>
+  static bool isDigit(CharT c)
+  {
+    return c >= '0' && c <= '9';
+  }
+
+  template <typename CharT>
+  static bool startsWith(const CharT* line, size_t length, const char* prefix)
+  {
+    size_t i = 0;
+    for (; prefix[i] != '\0'; ++i)
+    {
+      if (i >= length || line[i] != prefix[i])
+      {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  template <typename CharT>
+  static void tokenizeListItem(
+    const CharT* line, size_t length, LineToken& token
+  )
+  {
+    const size_t pos = token.indentation;
+    if (pos + 1 >= length)
+    {
+      return;
+    }
+
+    const CharT c = line[pos];
+    if ((c == '*' || c == '+' || c == '-') && line[pos + 1] == ' ')
+    {
+      token.listItem = types::UNORDERED_LIST_ITEM;
+      if (token.markerLength == 0)
+      {
+        token.markerLength = static_cast<uint32_t>(pos + 2);
+      }
+
+      if (pos == 0 && patterns::UnorderedListStart::Match(line, length))
+      {
+        token.startingParsers |= types::UNORDERED_LIST_PARSER;
+
+        if (c == '-' && patterns::ChecklistStart::Match(line, length))
+        {
+          token.startingParsers |= types::CHECKLIST_PARSER;
+        }
+      }
+      return;
+    }
+
+    if (c < '1' || c > '9')
+    {
+      return;
+    }
+
+    size_t digits = pos + 1;
+    while (digits < length && isDigit(line[digits]))
+    {
+      ++digits;
+    }
+
+    if (digits + 1 < length && line[digits] == '.' && line[digits + 1] == ' ')
+    {
+      token.listItem = types::ORDERED_LIST_ITEM;
+      if (token.markerLength == 0)
+      {
+        token.markerLength = static_cast<uint32_t>(digits + 2);
+      }
+
+      if (pos == 0 && patterns::OrderedListStart::Match(line, length))
+      {
+        token.startingParsers |= types::ORDERED_LIST_PARSER;
+      }
+    }
+  }
+}; // class LineTokenizer
+
+// -----------------------------------------------------------------------------
+
+} // namespace maddy
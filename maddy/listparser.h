@@ -0,0 +1,375 @@
+/*
+ * This project is licensed under the MIT license. For more information see the
+ * LICENSE file.
+ */
+#pragma once
+
+// -----------------------------------------------------------------------------
+
+#include <functional>
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include "maddy/blockparser.h"
+#include "maddy/parserconfig.h"
+
+// -----------------------------------------------------------------------------
+
+namespace maddy {
+
+// -----------------------------------------------------------------------------
+
+/**
+ * ListParser
+ *
+ * Shared by `OrderedListParser`, `UnorderedListParser` and `ChecklistParser`.
+ *
+ * The open lists are kept on a stack instead of one child parser per level.
+ * Every line goes through the levels once: each level either takes 2
+ * characters of indentation and hands the rest to the next level, starts a
+ * new item or ends the list. Starting a new item or ending the list also ends
+ * all deeper lists. A line that is not taken by the deepest level may open a
+ * nested list.
+ *
+ * `nestedParsers` tells which lists may be nested (`ORDERED_LIST_PARSER` and
+ * `UNORDERED_LIST_PARSER` in ordered and unordered lists, `CHECKLIST_PARSER`
+ * in checklists).
+ *
+ * @class
+ */
+class ListParser : public BlockParser
+{
+public:
+  /**
+   * ctor
+   *
+   * @method
+   * @param {std::function<void(std::string&)>} parseLineCallback
+   * @param {std::function<std::shared_ptr<BlockParser>(const std::string&
+   * line)>} getBlockParserForLineCallback
+   * @param {types::PARSER_TYPE} listType
+   * @param {uint32_t} nestedParsers
+   */
+  ListParser(
+    std::function<void(std::string&)> parseLineCallback,
+    std::function<std::shared_ptr<BlockParser>(const std::string& line)>
+      getBlockParserForLineCallback,
+    types::PARSER_TYPE listType,
+    uint32_t nestedParsers
+  )
+    : BlockParser(parseLineCallback, getBlockParserForLineCallback)
+    , listType(listType)
+    , nestedParsers(nestedParsers)
+    , isFinished(false)
+  {}
+
+  /**
+   * AddLine
+   *
+   * Adding a line which has to be parsed.
+   *
+   * @method
+   * @param {std::string&} line
+   * @return {void}
+   */
+  void AddLine(std::string& line) override
+  {
+    // like `.*` the rest of a marker line must not contain a line break
+    const size_t lastBreak = line.find_last_of("\r\n");
+    size_t offset = 0;
+    size_t textStart = 0;
+    const char* box = nullptr;
+    const char* tag = nullptr;
+    size_t level = 0;
+
+    for (; level < this->levels.size(); ++level)
+    {
+      Level& current = this->levels[level];
+      const bool isNewItem =
+        isItemStart(current.type, line, offset, lastBreak);
+
+      if (textStart < offset)
+      {
+        textStart = offset;
+      }
+      while (textStart < line.size() && isSpace(line[textStart]))
+      {
+        ++textStart;
+      }
+      const size_t indentation = textStart - offset;
+
+      offset = stripMarker(current.type, line, offset, box);
+
+      if (indentation >= 2)
+      {
+        offset += 2;
+        continue;
+      }
+
+      if (!box && offset == line.size())
+      {
+        tag = closeTag(current.type);
+        current.isFinished = true;
+        break;
+      }
+
+      if (isNewItem)
+      {
+        tag = itemTag(current.type);
+        break;
+      }
+
+      // the deeper levels get the checkbox as text
+      if (box)
+      {
+        break;
+      }
+    }
+
+    if (tag)
+    {
+      for (size_t deeper = this->levels.size() - 1; deeper > level; --deeper)
+      {
+        this->result << closeTag(this->levels[deeper].type);
+        this->levels[deeper].isFinished = true;
+      }
+      this->result << tag;
+    }
+    else if (!box)
+    {
+      const types::PARSER_TYPE nestedType = this->levels.empty()
+        ? this->listType
+        : this->nestedListType(
+            this->levels.back().type, line, offset, lastBreak
+          );
+
+      if (nestedType != types::NONE)
+      {
+        this->levels.push_back(Level{nestedType, false});
+        offset = stripMarker(nestedType, line, offset, box);
+        this->result << openTag(nestedType);
+      }
+    }
+
+    if (box)
+    {
+      this->result << box;
+    }
+
+    line.erase(0, offset);
+    this->parseLine(line);
+    this->result << line;
+
+    while (!this->levels.empty() && this->levels.back().isFinished)
+    {
+      this->levels.pop_back();
+    }
+    this->isFinished = this->levels.empty();
+  }
+
+  /**
+   * IsFinished
+   *
+   * @method
+   * @return {bool}
+   */
+  bool IsFinished() const override { return this->isFinished; }
+
+protected:
+  bool isInlineBlockAllowed() const override { return false; }
+
+  bool isLineParserAllowed() const override { return true; }
+
+  void parseBlock(std::string&) override {}
+
+private:
+  struct Level
+  {
+    types::PARSER_TYPE type;
+    bool isFinished;
+  };
+
+  types::PARSER_TYPE listType;
+  uint32_t nestedParsers;
+  bool isFinished;
+  std::vector<Level> levels;
+
+  static bool isSpace(char c)
+  {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\v' || c == '\f' ||
+           c == '\r';
+  }
+
+  static bool isAt(const std::string& line, size_t pos, char c)
+  {
+    return pos < line.size() && line[pos] == c;
+  }
+
+  // end of `[1-9][0-9]*\. ` at `pos` or `pos`
+  static size_t skipNumber(const std::string& line, size_t pos)
+  {
+    if (pos >= line.size() || line[pos] < '1' || line[pos] > '9')
+    {
+      return pos;
+    }
+
+    size_t end = pos + 1;
+    while (end < line.size() && line[end] >= '0' && line[end] <= '9')
+    {
+      ++end;
+    }
+    return isAt(line, end, '.') && isAt(line, end + 1, ' ') ? end + 2 : pos;
+  }
+
+  static bool isItemStart(
+    types::PARSER_TYPE type,
+    const std::string& line,
+    size_t pos,
+    size_t lastBreak
+  )
+  {
+    size_t end = pos;
+    if (type == types::CHECKLIST_PARSER)
+    {
+      // - [x] , - [ ] or - [|]
+      if (isAt(line, pos, '-') && isAt(line, pos + 1, ' ') &&
+          isAt(line, pos + 2, '[') && isAt(line, pos + 4, ']') &&
+          isAt(line, pos + 5, ' ') &&
+          (isAt(line, pos + 3, 'x') || isAt(line, pos + 3, '|') ||
+           isAt(line, pos + 3, ' ')))
+      {
+        end = pos + 6;
+      }
+    }
+    else if (type == types::ORDERED_LIST_PARSER)
+    {
+      end = skipNumber(line, pos);
+      if (end == pos && isAt(line, pos, '*') && isAt(line, pos + 1, ' '))
+      {
+        end = pos + 2;
+      }
+    }
+    else if ((isAt(line, pos, '+') || isAt(line, pos, '*') ||
+              isAt(line, pos, '-')) &&
+             isAt(line, pos + 1, ' '))
+    {
+      end = pos + 2;
+    }
+
+    return end != pos && (lastBreak == std::string::npos || lastBreak < end);
+  }
+
+  // `box` receives the checkbox that replaces `[ ]` or `[x]` of a checklist
+  static size_t stripMarker(
+    types::PARSER_TYPE type,
+    const std::string& line,
+    size_t pos,
+    const char*& box
+  )
+  {
+    if (type == types::CHECKLIST_PARSER)
+    {
+      if (isAt(line, pos, '-') && isAt(line, pos + 1, ' '))
+      {
+        pos += 2;
+      }
+      if (isAt(line, pos, '[') && isAt(line, pos + 2, ']'))
+      {
+        if (isAt(line, pos + 1, ' '))
+        {
+          box = "<input type=\"checkbox\"/>";
+          pos += 3;
+        }
+        else if (isAt(line, pos + 1, 'x'))
+        {
+          box = "<input type=\"checkbox\" checked=\"checked\"/>";
+          pos += 3;
+        }
+      }
+      return pos;
+    }
+
+    if (type == types::ORDERED_LIST_PARSER)
+    {
+      pos = skipNumber(line, pos);
+      return isAt(line, pos, '*') && isAt(line, pos + 1, ' ') ? pos + 2 : pos;
+    }
+
+    return (isAt(line, pos, '+') || isAt(line, pos, '*') ||
+            isAt(line, pos, '-')) &&
+        isAt(line, pos + 1, ' ')
+      ? pos + 2
+      : pos;
+  }
+
+  types::PARSER_TYPE nestedListType(
+    types::PARSER_TYPE parentType,
+    const std::string& line,
+    size_t pos,
+    size_t lastBreak
+  ) const
+  {
+    if (parentType == types::CHECKLIST_PARSER)
+    {
+      return (this->nestedParsers & types::CHECKLIST_PARSER) != 0 &&
+          isItemStart(types::CHECKLIST_PARSER, line, pos, lastBreak)
+        ? types::CHECKLIST_PARSER
+        : types::NONE;
+    }
+
+    // ^1\. .*
+    if ((this->nestedParsers & types::ORDERED_LIST_PARSER) != 0 &&
+        isAt(line, pos, '1') && isAt(line, pos + 1, '.') &&
+        isAt(line, pos + 2, ' ') &&
+        (lastBreak == std::string::npos || lastBreak < pos + 3))
+    {
+      return types::ORDERED_LIST_PARSER;
+    }
+
+    if ((this->nestedParsers & types::UNORDERED_LIST_PARSER) != 0 &&
+        isItemStart(types::UNORDERED_LIST_PARSER, line, pos, lastBreak))
+    {
+      return types::UNORDERED_LIST_PARSER;
+    }
+
+    return types::NONE;
+  }
+
+  static const char* openTag(types::PARSER_TYPE type)
+  {
+    switch (type)
+    {
+      case types::ORDERED_LIST_PARSER:
+        return "<ol><li>";
+      case types::CHECKLIST_PARSER:
+        return "<ul class=\"checklist\"><li><label>";
+      default:
+        return "<ul><li>";
+    }
+  }
+
+  static const char* itemTag(types::PARSER_TYPE type)
+  {
+    return type == types::CHECKLIST_PARSER ? "</label></li><li><label>"
+                                           : "</li><li>";
+  }
+
+  static const char* closeTag(types::PARSER_TYPE type)
+  {
+    switch (type)
+    {
+      case types::ORDERED_LIST_PARSER:
+        return "</li></ol>";
+      case types::CHECKLIST_PARSER:
+        return "</label></li></ul>";
+      default:
+        return "</li></ul>";
+    }
+  }
+}; // class ListParser
+
+// -----------------------------------------------------------------------------
+
+} // namespace maddy
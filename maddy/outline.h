@@ -0,0 +1,240 @@
+/*
+ * This project is licensed under the MIT license. For more information see the
+ * LICENSE file.
+ */
+#pragma once
+
+// -----------------------------------------------------------------------------
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+// -----------------------------------------------------------------------------
+
+namespace maddy {
+
+// -----------------------------------------------------------------------------
+
+/**
+ * Heading
+ *
+ * One headline of a document as recorded by the `HeadlineParser`.
+ *
+ * @class
+ */
+struct Heading
+{
+  uint32_t level;   // 1 - 6
+  std::string text; // markdown between `# ` and the end of the line
+  std::string id;   // unique within the document, used as `id` attribute
+  size_t line;      // 0-based line of the markdown
+}; // struct Heading
+
+// -----------------------------------------------------------------------------
+
+/**
+ * Outline
+ *
+ * Collects the headlines of one document in order and gives every one a
+ * unique id, so the HTML can be linked with `#id` and the editor can list the
+ * headlines without parsing the markdown itself.
+ *
+ * @class
+ */
+class Outline
+{
+public:
+  Outline() : line(0) {}
+
+  /**
+   * Slugify
+   *
+   * Lower case ASCII letters, digits, `-`, `_` and all non-ASCII bytes (so
+   * UTF-8 text stays as it is) are kept, everything else is dropped. Each run
+   * of whitespace between kept characters becomes one `-`, whitespace at the
+   * start and the end is left out.
+   *
+   * @method
+   * @param {const char*} text
+   * @param {size_t} length
+   * @return {std::string}
+   */
+  static std::string Slugify(const char* text, size_t length)
+  {
+    std::string slug;
+    slug.reserve(length);
+    WriteSlug(text, length, slug);
+    return slug;
+  }
+
+  /**
+   * WriteSlug
+   *
+   * `Slugify` for any `out` with `push_back(char)`, so that it can be checked
+   * at compile time.
+   *
+   * @method
+   * @param {const char*} text
+   * @param {size_t} length
+   * @param {Out&} out
+   */
+  template <typename Out>
+  static constexpr void WriteSlug(const char* text, size_t length, Out& out)
+  {
+    bool hasText = false;
+    bool hasSpace = false;
+
+    for (size_t i = 0; i < length; ++i)
+    {
+      const unsigned char c = static_cast<unsigned char>(text[i]);
+      if (c == ' ' || c == '\t' || c == '\r' || c == '\n')
+      {
+        hasSpace = hasText;
+        continue;
+      }
+
+      const bool isUpper = c >= 'A' && c <= 'Z';
+      if (!isUpper && !(c >= 'a' && c <= 'z') && !(c >= '0' && c <= '9') &&
+          c != '-' && c != '_' && c < 0x80)
+      {
+        continue;
+      }
+
+      if (hasSpace)
+      {
+        out.push_back('-');
+        hasSpace = false;
+      }
+      out.push_back(static_cast<char>(isUpper ? c - 'A' + 'a' : c));
+      hasText = true;
+    }
+  }
+
+  /**
+   * Add
+   *
+   * A headline with the same slug as an earlier one gets `-1`, `-2`, ...
+   * appended. Headlines without any kept character are called `section`.
+   *
+   * @method
+   * @param {uint32_t} level
+   * @param {const char*} text
+   * @param {size_t} length
+   * @return {const Heading&}
+   */
+  const Heading& Add(uint32_t level, const char* text, size_t length)
+  {
+    std::string slug = Slugify(text, length);
+    if (slug.empty())
+    {
+      slug = "section";
+    }
+
+    std::string id = slug;
+    if (!this->ids.insert(id).second)
+    {
+      // changelogs repeat the same headlines many times, so the next suffix
+      // is remembered per slug instead of counting up from 1 every time
+      size_t& suffix = this->nextSuffix[slug];
+      do
+      {
+        id = slug + "-" + std::to_string(++suffix);
+      } while (!this->ids.insert(id).second);
+    }
+
+    this->headings.push_back(
+      Heading{level, std::string(text, length), id, this->line}
+    );
+    return this->headings.back();
+  }
+
+  /**
+   * SetLine
+   *
+   * The `Parser` sets the line it is adding, so that headlines nested in other
+   * blocks get their own line as well.
+   *
+   * @method
+   * @param {size_t} line
+   */
+  void SetLine(size_t line) { this->line = line; }
+
+  const std::vector<Heading>& Headings() const { return this->headings; }
+
+  void Clear()
+  {
+    this->headings.clear();
+    this->ids.clear();
+    this->nextSuffix.clear();
+    this->line = 0;
+  }
+
+private:
+  std::vector<Heading> headings;
+  std::unordered_set<std::string> ids;
+  std::unordered_map<std::string, size_t> nextSuffix;
+  size_t line;
+}; // class Outline
+
+// -----------------------------------------------------------------------------
+
+namespace detail {
+
+struct SlugBuffer
+{
+  char data[32];
+  size_t size;
+
+  constexpr SlugBuffer() : data{}, size(0) {}
+
+  constexpr void push_back(char c)
+  {
+    if (this->size < sizeof(this->data))
+    {
+      this->data[this->size] = c;
+    }
+    ++this->size;
+  }
+}; // struct SlugBuffer
+
+template <size_t N, size_t M>
+constexpr bool slugifies(const char (&text)[N], const char (&slug)[M])
+{
+  SlugBuffer buffer;
+  Outline::WriteSlug(text, N - 1, buffer);
+  if (buffer.size != M - 1)
+  {
+    return false;
+  }
+  for (size_t i = 0; i < M - 1; ++i)
+  {
+    if (buffer.data[i] != slug[i])
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+} // namespace detail
+
+static_assert(detail::slugifies("Title", "title"), "");
+static_assert(detail::slugifies("Title  ", "title"), "");
+static_assert(detail::slugifies("  Title", "title"), "");
+static_assert(detail::slugifies("Two  Words", "two-words"), "");
+static_assert(detail::slugifies("Tab\tand space \r", "tab-and-space"), "");
+static_assert(detail::slugifies("C++ & Qt 5", "c-qt-5"), "");
+static_assert(detail::slugifies("a - b", "a---b"), "");
+static_assert(detail::slugifies("snake_case", "snake_case"), "");
+static_assert(
+  detail::slugifies("\xe6\xa8\x99\xe9\xa1\x8c", "\xe6\xa8\x99\xe9\xa1\x8c"), ""
+);
+static_assert(detail::slugifies(" & ", ""), "");
+
+// -----------------------------------------------------------------------------
+
+} // namespace maddy
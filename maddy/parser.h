@@ -9,7 +9,11 @@
 #include <functional>
 #include <memory>
 #include <string>
+#include <vector>
 
+#include "maddy/inlinememo.h"
+#include "maddy/linetokenizer.h"
+#include "maddy/outline.h"
 #include "maddy/parserconfig.h"
 
 // BlockParser
@@ -41,6 +45,20 @@ namespace maddy {
 
 // -----------------------------------------------------------------------------
 
+/**
+ * ParsedBlock
+ *
+ * HTML of one top level block together with the markdown lines it came from.
+ *
+ * @class
+ */
+struct ParsedBlock
+{
+  std::string html;
+  size_t firstLine;
+  size_t lineCount;
+}; // struct ParsedBlock
+
 /**
  * Parser
  *
@@ -131,24 +149,191 @@ public:
   std::string Parse(std::istream& markdown) const
   {
     std::string result = "";
+    this->parse(
+      markdown,
+      nullptr,
+      [&result](const std::string& html, size_t, size_t) { result += html; }
+    );
+    return result;
+  }
+
+  /**
+   * Parse
+   *
+   * Same as above, but reuses line tokens that were already computed (e.g. by
+   * the editor highlighter) instead of scanning those lines again. Tokens are
+   * matched by line index, unknown tokens are computed on the fly.
+   *
+   * @method
+   * @param {const std::istream&} markdown
+   * @param {const std::vector<LineToken>&} lineTokens
+   * @return {std::string} HTML
+   */
+  std::string Parse(
+    std::istream& markdown, const std::vector<LineToken>& lineTokens
+  ) const
+  {
+    std::string result = "";
+    this->parse(
+      markdown,
+      &lineTokens,
+      [&result](const std::string& html, size_t, size_t) { result += html; }
+    );
+    return result;
+  }
+
+  /**
+   * ParseBlocks
+   *
+   * Like `Parse`, but keeps the HTML of every top level block separate, so it
+   * can be handed out piece by piece (e.g. for a virtualized preview).
+   * `lineTokens` may be null.
+   *
+   * @method
+   * @param {const std::istream&} markdown
+   * @param {const std::vector<LineToken>*} lineTokens
+   * @return {std::vector<ParsedBlock>}
+   */
+  std::vector<ParsedBlock> ParseBlocks(
+    std::istream& markdown, const std::vector<LineToken>* lineTokens = nullptr
+  ) const
+  {
+    std::vector<ParsedBlock> blocks;
+    this->parse(
+      markdown,
+      lineTokens,
+      [&blocks](const std::string& html, size_t firstLine, size_t lineCount)
+      { blocks.push_back(ParsedBlock{html, firstLine, lineCount}); }
+    );
+    return blocks;
+  }
+
+  /**
+   * ParseBlocks
+   *
+   * Same as above for markdown that is already in memory, so it is not
+   * copied out of a stream first. The headlines are appended to `outline`,
+   * if it is given.
+   *
+   * @method
+   * @param {const std::string&} markdown
+   * @param {const std::vector<LineToken>*} lineTokens
+   * @param {Outline*} outline
+   * @return {std::vector<ParsedBlock>}
+   */
+  std::vector<ParsedBlock> ParseBlocks(
+    const std::string& markdown,
+    const std::vector<LineToken>* lineTokens = nullptr,
+    Outline* outline = nullptr
+  ) const
+  {
+    std::vector<ParsedBlock> blocks;
+    this->parse(
+      markdown,
+      lineTokens,
+      [&blocks](const std::string& html, size_t firstLine, size_t lineCount)
+      { blocks.push_back(ParsedBlock{html, firstLine, lineCount}); },
+      outline
+    );
+    return blocks;
+  }
+
+private:
+  std::shared_ptr<ParserConfig> config;
+  std::shared_ptr<BreakLineParser> breakLineParser;
+  std::shared_ptr<EmphasizedParser> emphasizedParser;
+  std::shared_ptr<ImageParser> imageParser;
+  std::shared_ptr<InlineCodeParser> inlineCodeParser;
+  std::shared_ptr<ItalicParser> italicParser;
+  std::shared_ptr<LinkParser> linkParser;
+  std::shared_ptr<StrikeThroughParser> strikeThroughParser;
+  std::shared_ptr<StrongParser> strongParser;
+
+  void parse(
+    std::istream& markdown,
+    const std::vector<LineToken>* lineTokens,
+    const std::function<void(const std::string&, size_t, size_t)>& onBlock
+  ) const
+  {
+    std::string buffer;
+    char chunk[16384];
+    while (markdown.read(chunk, sizeof(chunk)) || markdown.gcount() > 0)
+    {
+      buffer.append(chunk, static_cast<size_t>(markdown.gcount()));
+    }
+    this->parse(buffer, lineTokens, onBlock);
+  }
+
+  // splits the lines like std::getline, but code and LaTeX bodies are handed
+  // to their block parser as a whole
+  void parse(
+    const std::string& markdown,
+    const std::vector<LineToken>* lineTokens,
+    const std::function<void(const std::string&, size_t, size_t)>& onBlock,
+    Outline* outline = nullptr
+  ) const
+  {
+    // the headline ids have to be unique, also if nobody wants the outline
+    Outline documentOutline;
+    if (!outline)
+    {
+      outline = &documentOutline;
+    }
+
     std::shared_ptr<BlockParser> currentBlockParser = nullptr;
+    size_t lineIndex = 0;
+    size_t blockFirstLine = 0;
+    std::string line;
 
-    for (std::string line; std::getline(markdown, line);)
+    for (size_t pos = 0; pos < markdown.size(); ++lineIndex)
     {
+      size_t lineEnd = markdown.find('\n', pos);
+      if (lineEnd == std::string::npos)
+      {
+        lineEnd = markdown.size();
+      }
+      line.assign(markdown, pos, lineEnd - pos);
+      pos = lineEnd + 1;
+
+      bool isNewBlock = false;
       if (!currentBlockParser)
       {
-        currentBlockParser = getBlockParserForLine(line);
+        if (lineTokens && lineIndex < lineTokens->size() &&
+            (*lineTokens)[lineIndex].isKnown)
+        {
+          currentBlockParser =
+            getBlockParserForToken((*lineTokens)[lineIndex], outline);
+        }
+        else
+        {
+          currentBlockParser = getBlockParserForLine(line, outline);
+        }
+        blockFirstLine = lineIndex;
+        isNewBlock = true;
       }
 
       if (currentBlockParser)
       {
+        outline->SetLine(lineIndex);
         currentBlockParser->AddLine(line);
 
         if (currentBlockParser->IsFinished())
         {
-          result += currentBlockParser->GetResult().str();
+          onBlock(
+            currentBlockParser->GetResult().str(),
+            blockFirstLine,
+            lineIndex - blockFirstLine + 1
+          );
           currentBlockParser = nullptr;
         }
+        else if (isNewBlock && pos < markdown.size())
+        {
+          size_t lineCount = 0;
+          pos += currentBlockParser->AddVerbatim(
+            markdown.data() + pos, markdown.size() - pos, lineCount
+          );
+          lineIndex += lineCount;
+        }
       }
     }
 
@@ -159,28 +344,72 @@ public:
       currentBlockParser->AddLine(emptyLine);
       if (currentBlockParser->IsFinished())
       {
-        result += currentBlockParser->GetResult().str();
+        onBlock(
+          currentBlockParser->GetResult().str(),
+          blockFirstLine,
+          lineIndex - blockFirstLine
+        );
         currentBlockParser = nullptr;
       }
     }
+  }
 
-    return result;
+  /**
+   * enabled block parsers
+   *
+   * Without config all parsers of `DEFAULT` are enabled, which leaves out
+   * `LATEX_BLOCK_PARSER` and `HTML_PARSER` like before.
+   */
+  uint32_t enabledParsers() const
+  {
+    return this->config ? this->config->enabledParsers : maddy::types::DEFAULT;
   }
 
-private:
-  std::shared_ptr<ParserConfig> config;
-  std::shared_ptr<BreakLineParser> breakLineParser;
-  std::shared_ptr<EmphasizedParser> emphasizedParser;
-  std::shared_ptr<ImageParser> imageParser;
-  std::shared_ptr<InlineCodeParser> inlineCodeParser;
-  std::shared_ptr<ItalicParser> italicParser;
-  std::shared_ptr<LinkParser> linkParser;
-  std::shared_ptr<StrikeThroughParser> strikeThroughParser;
-  std::shared_ptr<StrongParser> strongParser;
+  /**
+   * enabled inline parsers
+   *
+   * Part of the key of the `InlineMemo`, so that parsers with another
+   * configuration do not get each others results.
+   */
+  uint32_t enabledInlineParsers() const
+  {
+    return this->enabledParsers() &
+           (maddy::types::BREAKLINE_PARSER | maddy::types::EMPHASIZED_PARSER |
+            maddy::types::IMAGE_PARSER | maddy::types::INLINE_CODE_PARSER |
+            maddy::types::ITALIC_PARSER | maddy::types::LINK_PARSER |
+            maddy::types::STRIKETHROUGH_PARSER | maddy::types::STRONG_PARSER);
+  }
 
   // block parser have to run before
   void runLineParser(std::string& line) const
   {
+    InlineMemo* memo = this->config ? this->config->inlineMemo.get() : nullptr;
+    if (!memo)
+    {
+      this->transformLine(line);
+      return;
+    }
+
+    const uint32_t inlineParsers = this->enabledInlineParsers();
+    if (memo->Find(line, inlineParsers, line))
+    {
+      return;
+    }
+
+    const std::string original = line;
+    this->transformLine(line);
+    memo->Insert(original, inlineParsers, line);
+  }
+
+  void transformLine(std::string& line) const
+  {
+    // Attention! InlineCodeParser has to be first, it protects the code from
+    // the other parsers
+    if (this->inlineCodeParser)
+    {
+      this->inlineCodeParser->Parse(line);
+    }
+
     // Attention! ImageParser has to be before LinkParser
     if (this->imageParser)
     {
@@ -208,11 +437,6 @@ private:
       this->strikeThroughParser->Parse(line);
     }
 
-    if (this->inlineCodeParser)
-    {
-      this->inlineCodeParser->Parse(line);
-    }
-
     if (this->italicParser)
     {
       this->italicParser->Parse(line);
@@ -224,176 +448,101 @@ private:
     }
   }
 
-  std::shared_ptr<BlockParser> getBlockParserForLine(const std::string& line
+  std::shared_ptr<BlockParser> getBlockParserForLine(
+    const std::string& line, Outline* outline
+  ) const
+  {
+    return this->getBlockParserForToken(LineTokenizer::Tokenize(line), outline);
+  }
+
+  std::shared_ptr<BlockParser> getBlockParserForToken(
+    const LineToken& token, Outline* outline
   ) const
   {
     std::shared_ptr<BlockParser> parser;
+    const uint32_t candidates = token.startingParsers & this->enabledParsers();
 
-    if ((!this->config || (this->config->enabledParsers &
-                           maddy::types::CODE_BLOCK_PARSER) != 0) &&
-        maddy::CodeBlockParser::IsStartingLine(line))
+    if ((candidates & maddy::types::CODE_BLOCK_PARSER) != 0)
     {
       parser = std::make_shared<maddy::CodeBlockParser>(nullptr, nullptr);
     }
-    else if (this->config &&
-             (this->config->enabledParsers & maddy::types::LATEX_BLOCK_PARSER
-             ) != 0 &&
-             maddy::LatexBlockParser::IsStartingLine(line))
+    else if ((candidates & maddy::types::LATEX_BLOCK_PARSER) != 0)
     {
       parser = std::make_shared<LatexBlockParser>(nullptr, nullptr);
     }
-    else if ((!this->config || (this->config->enabledParsers &
-                                maddy::types::HEADLINE_PARSER) != 0) &&
-             maddy::HeadlineParser::IsStartingLine(line))
+    else if ((candidates & maddy::types::HEADLINE_PARSER) != 0)
     {
       if (!this->config || this->config->isHeadlineInlineParsingEnabled)
       {
         parser = std::make_shared<maddy::HeadlineParser>(
           [this](std::string& line) { this->runLineParser(line); },
           nullptr,
-          true
+          true,
+          outline
         );
       }
       else
       {
-        parser =
-          std::make_shared<maddy::HeadlineParser>(nullptr, nullptr, false);
+        parser = std::make_shared<maddy::HeadlineParser>(
+          nullptr, nullptr, false, outline
+        );
       }
     }
-    else if ((!this->config || (this->config->enabledParsers &
-                                maddy::types::HORIZONTAL_LINE_PARSER) != 0) &&
-             maddy::HorizontalLineParser::IsStartingLine(line))
+    else if ((candidates & maddy::types::HORIZONTAL_LINE_PARSER) != 0)
     {
       parser = std::make_shared<maddy::HorizontalLineParser>(nullptr, nullptr);
     }
-    else if ((!this->config || (this->config->enabledParsers &
-                                maddy::types::QUOTE_PARSER) != 0) &&
-             maddy::QuoteParser::IsStartingLine(line))
+    else if ((candidates & maddy::types::QUOTE_PARSER) != 0)
     {
       parser = std::make_shared<maddy::QuoteParser>(
-        [this](std::string& line) { this->runLineParser(line); },
-        [this](const std::string& line)
-        { return this->getBlockParserForLine(line); }
+        [this](std::string& line) { this->runLineParser(line); }, nullptr
       );
     }
-    else if ((!this->config || (this->config->enabledParsers &
-                                maddy::types::TABLE_PARSER) != 0) &&
-             maddy::TableParser::IsStartingLine(line))
+    else if ((candidates & maddy::types::TABLE_PARSER) != 0)
     {
       parser = std::make_shared<maddy::TableParser>(
         [this](std::string& line) { this->runLineParser(line); }, nullptr
       );
     }
-    else if ((!this->config || (this->config->enabledParsers &
-                                maddy::types::CHECKLIST_PARSER) != 0) &&
-             maddy::ChecklistParser::IsStartingLine(line))
+    else if ((candidates & maddy::types::CHECKLIST_PARSER) != 0)
     {
-      parser = this->createChecklistParser();
+      parser = std::make_shared<maddy::ChecklistParser>(
+        [this](std::string& line) { this->runLineParser(line); },
+        nullptr,
+        this->enabledParsers()
+      );
     }
-    else if ((!this->config || (this->config->enabledParsers &
-                                maddy::types::ORDERED_LIST_PARSER) != 0) &&
-             maddy::OrderedListParser::IsStartingLine(line))
+    else if ((candidates & maddy::types::ORDERED_LIST_PARSER) != 0)
     {
-      parser = this->createOrderedListParser();
+      parser = std::make_shared<maddy::OrderedListParser>(
+        [this](std::string& line) { this->runLineParser(line); },
+        nullptr,
+        this->enabledParsers()
+      );
     }
-    else if ((!this->config || (this->config->enabledParsers &
-                                maddy::types::UNORDERED_LIST_PARSER) != 0) &&
-             maddy::UnorderedListParser::IsStartingLine(line))
+    else if ((candidates & maddy::types::UNORDERED_LIST_PARSER) != 0)
     {
-      parser = this->createUnorderedListParser();
+      parser = std::make_shared<maddy::UnorderedListParser>(
+        [this](std::string& line) { this->runLineParser(line); },
+        nullptr,
+        this->enabledParsers()
+      );
     }
-    else if (this->config &&
-             (this->config->enabledParsers & maddy::types::HTML_PARSER) != 0 &&
-             maddy::HtmlParser::IsStartingLine(line))
+    else if ((candidates & maddy::types::HTML_PARSER) != 0)
     {
       parser = std::make_shared<maddy::HtmlParser>(nullptr, nullptr);
     }
-    else if (maddy::ParagraphParser::IsStartingLine(line))
+    else if ((token.startingParsers & maddy::types::PARAGRAPH_PARSER) != 0)
     {
       parser = std::make_shared<maddy::ParagraphParser>(
         [this](std::string& line) { this->runLineParser(line); },
         nullptr,
-        (!this->config ||
-         (this->config->enabledParsers & maddy::types::PARAGRAPH_PARSER) != 0)
+        (this->enabledParsers() & maddy::types::PARAGRAPH_PARSER) != 0
       );
     }
 
     return parser;
   }
-
-  std::shared_ptr<BlockParser> createChecklistParser() const
-  {
-    return std::make_shared<maddy::ChecklistParser>(
-      [this](std::string& line) { this->runLineParser(line); },
-      [this](const std::string& line)
-      {
-        std::shared_ptr<BlockParser> parser;
-
-        if ((!this->config || (this->config->enabledParsers &
-                               maddy::types::CHECKLIST_PARSER) != 0) &&
-            maddy::ChecklistParser::IsStartingLine(line))
-        {
-          parser = this->createChecklistParser();
-        }
-
-        return parser;
-      }
-    );
-  }
-
-  std::shared_ptr<BlockParser> createOrderedListParser() const
-  {
-    return std::make_shared<maddy::OrderedListParser>(
-      [this](std::string& line) { this->runLineParser(line); },
-      [this](const std::string& line)
-      {
-        std::shared_ptr<BlockParser> parser;
-
-        if ((!this->config || (this->config->enabledParsers &
-                               maddy::types::ORDERED_LIST_PARSER) != 0) &&
-            maddy::OrderedListParser::IsStartingLine(line))
-        {
-          parser = this->createOrderedListParser();
-        }
-        else if ((!this->config || (this->config->enabledParsers &
-                                    maddy::types::UNORDERED_LIST_PARSER) != 0
-                 ) &&
-                 maddy::UnorderedListParser::IsStartingLine(line))
-        {
-          parser = this->createUnorderedListParser();
-        }
-
-        return parser;
-      }
-    );
-  }
-
-  std::shared_ptr<BlockParser> createUnorderedListParser() const
-  {
-    return std::make_shared<maddy::UnorderedListParser>(
-      [this](std::string& line) { this->runLineParser(line); },
-      [this](const std::string& line)
-      {
-        std::shared_ptr<BlockParser> parser;
-
-        if ((!this->config || (this->config->enabledParsers &
-                               maddy::types::ORDERED_LIST_PARSER) != 0) &&
-            maddy::OrderedListParser::IsStartingLine(line))
-        {
-          parser = this->createOrderedListParser();
-        }
-        else if ((!this->config || (this->config->enabledParsers &
-                                    maddy::types::UNORDERED_LIST_PARSER) != 0
-                 ) &&
-                 maddy::UnorderedListParser::IsStartingLine(line))
-        {
-          parser = this->createUnorderedListParser();
-        }
-
-        return parser;
-      }
-    );
-  }
 }; // class Parser
 
 // -----------------------------------------------------------------------------
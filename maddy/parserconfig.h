@@ -4,6 +4,7 @@
  */
 #pragma once
 
+#include <memory>
 #include <stdint.h>
 
 // -----------------------------------------------------------------------------
@@ -12,6 +13,10 @@ namespace maddy {
 
 // -----------------------------------------------------------------------------
 
+class InlineMemo;
+
+// -----------------------------------------------------------------------------
+
 namespace types {
 
 // clang-format off
@@ -70,9 +75,17 @@ struct ParserConfig
    */
   uint32_t enabledParsers;
 
+  /**
+   * memo for the inline parsers, may be shared between parsers
+   *
+   * default: nullptr, every line runs through all inline parsers
+   */
+  std::shared_ptr<InlineMemo> inlineMemo;
+
   ParserConfig()
     : isHeadlineInlineParsingEnabled(true)
     , enabledParsers(maddy::types::DEFAULT)
+    , inlineMemo(nullptr)
   {}
 }; // class ParserConfig
 
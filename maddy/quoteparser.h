@@ -7,8 +7,7 @@
 // -----------------------------------------------------------------------------
 
 #include <functional>
-#include <memory>
-#include <regex>
+#include <stddef.h>
 #include <string>
 
 #include "maddy/blockparser.h"
@@ -41,7 +40,7 @@ public:
       getBlockParserForLineCallback
   )
     : BlockParser(parseLineCallback, getBlockParserForLineCallback)
-    , isStarted(false)
+    , depth(0)
     , isFinished(false)
   {}
 
@@ -62,7 +61,12 @@ public:
   /**
    * AddLine
    *
-   * Adding a line which has to be parsed, with corrected nesting logic.
+   * Adding a line which has to be parsed.
+   *
+   * The depth of the line is the count of its leading `>` (each may be
+   * followed by one space). The difference to the current depth opens or
+   * closes the nested quotes, so there is no parser per level and the line
+   * is not copied per level. A line without `>` closes all quotes.
    *
    * @method
    * @param {std::string&} line
@@ -70,75 +74,32 @@ public:
    */
   void AddLine(std::string& line) override
   {
-    if (!this->isStarted)
+    size_t lineDepth = 0;
+    size_t offset = 0;
+    while (offset < line.size() && line[offset] == '>')
     {
-      this->result << "<blockquote>";
-      this->isStarted = true;
+      ++lineDepth;
+      offset += (offset + 1 < line.size() && line[offset + 1] == ' ') ? 2 : 1;
     }
 
-    // --- FIX START: Correct termination logic ---
-
-    // If a line is not a quote, it's a signal to end the block.
-    if (!IsStartingLine(line))
+    for (; this->depth < lineDepth; ++this->depth)
     {
-      // If there's an active child, it must be terminated first.
-      // We pass the non-quote line to it, which will trigger its own finish logic.
-      if (this->childParser)
-      {
-        this->childParser->AddLine(line);
-        // Now that the child has processed the end signal, we collect its COMPLETE result.
-        this->result << this->childParser->GetResult().str();
-        this->childParser = nullptr;
-      }
-
-      // Now, terminate the parent parser.
-      this->result << "</blockquote>";
-      this->isFinished = true;
-      return;
-    }
-
-    // --- FIX END ---
-
-    // The line is a valid quote line. Strip one level of ">".
-    std::string content = line;
-    if (content.length() > 1 && content[1] == ' ')
-    {
-      content.erase(0, 2); // Remove "> "
+      this->result << "<blockquote>";
     }
-    else
+    for (; this->depth > lineDepth; --this->depth)
     {
-      content.erase(0, 1); // Remove ">"
+      this->result << "</blockquote>";
     }
 
-    // If a child parser is already active, pass the stripped content to it.
-    if (this->childParser)
-    {
-      this->childParser->AddLine(content);
-
-      // After processing, check if the child has finished (e.g., went from `>>` to `>`).
-      if (this->childParser->IsFinished())
-      {
-        this->result << this->childParser->GetResult().str();
-        this->childParser = nullptr;
-      }
-    }
-    else // No active child parser.
+    if (lineDepth == 0)
     {
-      // Check if the stripped content is ALSO a quote, meaning we need to START nesting.
-      if (IsStartingLine(content))
-      {
-        this->childParser = std::make_shared<QuoteParser>(
-          this->parseLineCallback,
-          this->getBlockParserForLineCallback
-        );
-        this->childParser->AddLine(content);
-      }
-      else // Not nested, just regular content for the current quote level.
-      {
-        this->parseLine(content);
-        this->result << content << "<br/>";
-      }
+      this->isFinished = true;
+      return;
     }
+
+    line.erase(0, offset);
+    this->parseLine(line);
+    this->result << line << "<br/>";
   }
 
   /**
@@ -150,14 +111,14 @@ public:
   bool IsFinished() const override { return this->isFinished; }
 
 protected:
-  bool isInlineBlockAllowed() const override { return true; }
+  bool isInlineBlockAllowed() const override { return false; }
 
   bool isLineParserAllowed() const override { return true; }
 
   void parseBlock(std::string& /*line*/) override {}
 
 private:
-  bool isStarted;
+  size_t depth; // count of open `<blockquote>`
   bool isFinished;
 }; // class QuoteParser
 
@@ -11,9 +11,9 @@
 #include <regex>
 #include <string>
 #include <vector>
-#include <sstream> // For std::stringstream
 
 #include "maddy/blockparser.h"
+#include "maddy/htmlescaper.h"
 
 // -----------------------------------------------------------------------------
 
@@ -48,7 +48,7 @@ public:
     , isStarted(false)
     , isFinished(false)
     , currentBlock(0)
-    , currentRow(0)
+    , rowCount(0)
   {}
 
   /**
@@ -71,6 +71,11 @@ public:
    *
    * Adding a line which has to be parsed.
    *
+   * Rows are written to the result as soon as their section is known. Only
+   * the first block (`<thead>`, or `<tbody>` if it stays the only one) and
+   * the blocks after the second one (`<tfoot>`, if it is the last one) have
+   * to wait for the next separator or the end of the table.
+   *
    * @method
    * @param {std::string&} line
    * @return {void}
@@ -80,56 +85,30 @@ public:
     if (!this->isStarted && line == "|table>")
     {
       this->isStarted = true;
+      this->result << "<table>";
       return;
     }
 
-    if (this->isStarted)
+    if (!this->isStarted)
     {
-      if (line == "- | - | -" || line == "---|---" || line == "-|-|-" ) // Made separator more flexible
-      {
-        ++this->currentBlock;
-        this->currentRow = 0;
-        return;
-      }
-
-      if (line == "|<table")
-      {
-        static std::string emptyLine = "";
-        this->parseBlock(emptyLine);
-        this->isFinished = true;
-        return;
-      }
-
-      if (this->table.size() < this->currentBlock + 1)
-      {
-        this->table.push_back(std::vector<std::vector<std::string>>());
-      }
-      this->table[this->currentBlock].push_back(std::vector<std::string>());
-
-      // --- FIX START ---
-      // Trim leading and trailing pipes to prevent empty columns
-      std::string lineToSplit = line;
-      if (!lineToSplit.empty() && lineToSplit.front() == '|')
-      {
-        lineToSplit.erase(0, 1);
-      }
-      if (!lineToSplit.empty() && lineToSplit.back() == '|')
-      {
-        lineToSplit.pop_back();
-      }
-      // --- FIX END ---
-
-      std::string segment;
-      std::stringstream streamToSplit(lineToSplit); // Use the trimmed string
+      return;
+    }
 
-      while (std::getline(streamToSplit, segment, '|'))
-      {
-        this->parseLine(segment); // This presumably handles inline markdown like **bold**
-        this->table[this->currentBlock][this->currentRow].push_back(segment);
-      }
+    if (line == "- | - | -" || line == "---|---" || line == "-|-|-" ) // Made separator more flexible
+    {
+      this->closeBlock(false);
+      return;
+    }
 
-      ++this->currentRow;
+    if (line == "|<table")
+    {
+      this->closeBlock(true);
+      this->result << "</table>";
+      this->isFinished = true;
+      return;
     }
+
+    this->addRow(line);
   }
 
   /**
@@ -147,93 +126,192 @@ protected:
 
   bool isLineParserAllowed() const override { return true; }
 
-  void parseBlock(std::string&) override
+  void parseBlock(std::string&) override {}
+
+private:
+  /**
+   * escapeOutsideCode
+   *
+   * Cell text is shown literally. Inline code spans are left to the
+   * `InlineCodeParser`, which escapes them itself.
+   *
+   * @method
+   * @param {std::string&} cell
+   */
+  static void escapeOutsideCode(std::string& cell)
   {
-    result << "<table>";
+    size_t open = cell.find('`');
+    size_t close = open != std::string::npos ? cell.find('`', open + 1)
+                                             : std::string::npos;
+    if (close == std::string::npos)
+    {
+      HtmlEscaper::Escape(cell);
+      return;
+    }
 
-    bool hasHeader = false;
-    bool hasFooter = false;
-    bool isFirstBlock = true;
-    uint32_t currentBlockNumber = 0;
+    std::string result;
+    result.reserve(cell.size() + 16);
+    size_t pos = 0;
 
-    // A table has a header if it has more than one block (e.g., header and body)
-    if (this->table.size() > 1)
+    while (close != std::string::npos)
     {
-      hasHeader = true;
+      HtmlEscaper::Append(result, cell.data() + pos, open - pos);
+      result.append(cell, open, close - open + 1);
+
+      pos = close + 1;
+      open = cell.find('`', pos);
+      close = open != std::string::npos ? cell.find('`', open + 1)
+                                        : std::string::npos;
     }
 
-    // A table has a footer if it has 3 or more blocks (header, body, footer)
-    if (this->table.size() >= 3)
+    HtmlEscaper::Append(result, cell.data() + pos, cell.size() - pos);
+    cell.swap(result);
+  }
+
+  /**
+   * addRow
+   *
+   * Splits the row at `|` (without a leading and trailing one, so that there
+   * are no empty outer columns) and runs the line parsers on every cell. The
+   * second block is always a `<tbody>`, so its rows go straight to the
+   * result, the other blocks are kept in `cells` until `closeBlock`.
+   *
+   * @method
+   * @param {const std::string&} line
+   */
+  void addRow(const std::string& line)
+  {
+    size_t begin = 0;
+    size_t end = line.size();
+    if (begin < end && line[begin] == '|')
     {
-      hasFooter = true;
+      ++begin;
     }
-
-    for (const auto& block : this->table)
+    if (begin < end && line[end - 1] == '|')
     {
-      bool isInHeader = false;
-      bool isInFooter = false;
-      ++currentBlockNumber;
+      --end;
+    }
 
-      if (hasHeader && isFirstBlock)
-      {
-        result << "<thead>";
-        isInHeader = true;
-      }
-      else if (hasFooter && currentBlockNumber == this->table.size())
-      {
-        result << "<tfoot>";
-        isInFooter = true;
-      }
-      else
+    const bool isStreamed = this->currentBlock == 1;
+    if (isStreamed)
+    {
+      if (this->rowCount == 0)
       {
-        result << "<tbody>";
+        this->result << "<tbody>";
       }
+      this->result << "<tr>";
+    }
 
-      for (const auto& row : block)
+    // like std::getline: "a|b|" has two cells, "" has none
+    while (begin < end)
+    {
+      size_t cellEnd = line.find('|', begin);
+      if (cellEnd == std::string::npos || cellEnd > end)
       {
-        result << "<tr>";
-
-        for (const auto& column : row)
-        {
-          if (isInHeader)
-          {
-            result << "<th>" << column << "</th>";
-          }
-          else
-          {
-            result << "<td>" << column << "</td>";
-          }
-        }
-
-        result << "</tr>";
+        cellEnd = end;
       }
 
-      if (isInHeader)
-      {
-        result << "</thead>";
-      }
-      else if (isInFooter)
+      this->cell.assign(line, begin, cellEnd - begin);
+      escapeOutsideCode(this->cell);
+      this->parseLine(this->cell);
+
+      if (isStreamed)
       {
-        result << "</tfoot>";
+        this->result << "<td>" << this->cell << "</td>";
       }
       else
       {
-        result << "</tbody>";
+        this->cells += this->cell;
+        this->cellEnds.push_back(this->cells.size());
       }
 
-      isFirstBlock = false;
+      begin = cellEnd + 1;
     }
 
-    result << "</table>";
+    if (isStreamed)
+    {
+      this->result << "</tr>";
+    }
+    else
+    {
+      this->rowEnds.push_back(this->cellEnds.size());
+    }
+    ++this->rowCount;
+  }
+
+  /**
+   * closeBlock
+   *
+   * With more than one block the first one is the `<thead>`, with three or
+   * more the last one is the `<tfoot>`, all others are `<tbody>`. Separators
+   * without rows in between do not start another block.
+   *
+   * @method
+   * @param {bool} isLast
+   */
+  void closeBlock(bool isLast)
+  {
+    if (this->rowCount == 0)
+    {
+      return;
+    }
+
+    if (this->currentBlock == 1)
+    {
+      this->result << "</tbody>";
+    }
+    else if (this->currentBlock == 0)
+    {
+      this->flushRows(isLast ? "tbody" : "thead", isLast ? "td" : "th");
+    }
+    else
+    {
+      this->flushRows(isLast ? "tfoot" : "tbody", "td");
+    }
+
+    ++this->currentBlock;
+    this->rowCount = 0;
+  }
+
+  void flushRows(const char* section, const char* cellTag)
+  {
+    this->result << '<' << section << '>';
+
+    size_t cellIndex = 0;
+    size_t cellBegin = 0;
+    for (const size_t rowEnd : this->rowEnds)
+    {
+      this->result << "<tr>";
+      for (; cellIndex < rowEnd; ++cellIndex)
+      {
+        const size_t cellEnd = this->cellEnds[cellIndex];
+        this->result << '<' << cellTag << '>';
+        this->result.write(
+          this->cells.data() + cellBegin,
+          static_cast<std::streamsize>(cellEnd - cellBegin)
+        );
+        this->result << "</" << cellTag << '>';
+        cellBegin = cellEnd;
+      }
+      this->result << "</tr>";
+    }
+
+    this->result << "</" << section << '>';
+
+    this->cells.clear();
+    this->cellEnds.clear();
+    this->rowEnds.clear();
   }
 
-private:
   bool isStarted;
   bool isFinished;
   uint32_t currentBlock;
-  uint32_t currentRow;
-  // 3D vector: table -> blocks (thead/tbody/tfoot) -> rows -> columns
-  std::vector<std::vector<std::vector<std::string>>> table;
+  uint32_t rowCount; // rows of the current block
+  std::string cell;
+  // cells of the rows that wait for their section, one after another
+  std::string cells;
+  std::vector<size_t> cellEnds; // end of every cell in `cells`
+  std::vector<size_t> rowEnds;  // end of every row in `cellEnds`
 }; // class TableParser
 
 // -----------------------------------------------------------------------------
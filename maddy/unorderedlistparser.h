@@ -7,10 +7,10 @@
 // -----------------------------------------------------------------------------
 
 #include <functional>
-#include <regex>
 #include <string>
 
-#include "maddy/blockparser.h"
+#include "maddy/linematcher.h"
+#include "maddy/listparser.h"
 
 // -----------------------------------------------------------------------------
 
@@ -23,7 +23,7 @@ namespace maddy {
  *
  * @class
  */
-class UnorderedListParser : public BlockParser
+class UnorderedListParser : public ListParser
 {
 public:
   /**
@@ -33,15 +33,21 @@ public:
    * @param {std::function<void(std::string&)>} parseLineCallback
    * @param {std::function<std::shared_ptr<BlockParser>(const std::string&
    * line)>} getBlockParserForLineCallback
+   * @param {uint32_t} nestedParsers lists that may be nested
    */
   UnorderedListParser(
     std::function<void(std::string&)> parseLineCallback,
     std::function<std::shared_ptr<BlockParser>(const std::string& line)>
-      getBlockParserForLineCallback
+      getBlockParserForLineCallback,
+    uint32_t nestedParsers =
+      types::ORDERED_LIST_PARSER | types::UNORDERED_LIST_PARSER
   )
-    : BlockParser(parseLineCallback, getBlockParserForLineCallback)
-    , isStarted(false)
-    , isFinished(false)
+    : ListParser(
+        parseLineCallback,
+        getBlockParserForLineCallback,
+        types::UNORDERED_LIST_PARSER,
+        nestedParsers
+      )
   {}
 
   /**
@@ -55,62 +61,8 @@ public:
    */
   static bool IsStartingLine(const std::string& line)
   {
-    static std::regex re("^[+*-] .*");
-    return std::regex_match(line, re);
+    return patterns::UnorderedListStart::Match(line);
   }
-
-  /**
-   * IsFinished
-   *
-   * @method
-   * @return {bool}
-   */
-  bool IsFinished() const override { return this->isFinished; }
-
-protected:
-  bool isInlineBlockAllowed() const override { return true; }
-
-  bool isLineParserAllowed() const override { return true; }
-
-  void parseBlock(std::string& line) override
-  {
-    bool isStartOfNewListItem = IsStartingLine(line);
-    uint32_t indentation = getIndentationWidth(line);
-
-    static std::regex lineRegex("^([+*-] )");
-    line = std::regex_replace(line, lineRegex, "");
-
-    if (!this->isStarted)
-    {
-      line = "<ul><li>" + line;
-      this->isStarted = true;
-      return;
-    }
-
-    if (indentation >= 2)
-    {
-      line = line.substr(2);
-      return;
-    }
-
-    if (line.empty() || line.find("</li><li>") != std::string::npos ||
-        line.find("</li></ol>") != std::string::npos ||
-        line.find("</li></ul>") != std::string::npos)
-    {
-      line = "</li></ul>" + line;
-      this->isFinished = true;
-      return;
-    }
-
-    if (isStartOfNewListItem)
-    {
-      line = "</li><li>" + line;
-    }
-  }
-
-private:
-  bool isStarted;
-  bool isFinished;
 }; // class UnorderedListParser
 
 // -----------------------------------------------------------------------------
@@ -1,4 +1,6 @@
 #include "mainwindow.h"
+#include "parserwarmup.h"
+#include "previewschemehandler.h"
 
 #include <QApplication>
 #include <QFile>
@@ -7,7 +9,11 @@
 int main(int argc, char *argv[])
 {
     QApplication::setAttribute(Qt::AA_EnableHighDpiScaling);
+    PreviewSchemeHandler::registerScheme(); // 自訂網址必須在 QApplication 之前註冊
     QApplication a(argc, argv);
+    a.setOrganizationName("MarkdownEditor"); // QSettings 的儲存位置
+    a.setApplicationName("MarkdownEditor");
+    ParserWarmUp::start(); // 與建立視窗同時在背景編譯 maddy 的 regex
     QFile styleFile(":/style.qss");
     if (styleFile.open(QFile::ReadOnly)) {
         QString styleSheet = QLatin1String(styleFile.readAll());
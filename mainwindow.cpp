@@ -1,20 +1,24 @@
 ﻿// 在 mainwindow.cpp 中
 #include "mainwindow.h"
 #include "ui_mainwindow.h"
-#include <sstream>
 #include <memory>
 
 #include "maddy/parser.h"
 #include "markdownhighlighter.h"
+#include "editorgutter.h"
+#include "contenthash.h"
+#include "executorpanel.h"
+#include "textbrowserpreview.h"
+#include "webenginepreview.h"
 #include "maddy/parserconfig.h"
 
 #include <QGraphicsDropShadowEffect>
-#include <QWebEnginePage>
 #include <QScrollBar>
 #include <QTimer>
 #include <QHBoxLayout>
 #include <QSplitter>
-#include <QWebEngineView>
+#include <QSettings>
+#include <QActionGroup>
 #include <QScreen>
 #include <QGuiApplication>
 #include <QMenuBar>
@@ -27,14 +31,46 @@
 #include <QCloseEvent>
 #include <QInputDialog>
 
+namespace {
+// 預覽引擎設定的鍵值，值為 "webengine" 或 "textbrowser"
+const char kPreviewBackendKey[] = "preview/backend";
+
+// 行內轉換快取的記憶體上限 (位元組)
+const char kInlineMemoBytesKey[] = "preview/inlineMemoBytes";
+const int kDefaultInlineMemoBytes = 4 * 1024 * 1024;
+
+// 磁碟文件快取的大小上限 (位元組)
+const char kDocumentCacheBytesKey[] = "cache/documentCacheBytes";
+const qint64 kDefaultDocumentCacheBytes = 256 * 1024 * 1024;
+
+// 開啟檔案後記錄時間的轉換次數：第一次，以及之後一次作為穩定狀態的對照
+const int kTimedParsesAfterLoad = 2;
+
+// 預覽使用的 parser 設定
+quint32 previewParsers()
+{
+    quint32 parsers = maddy::types::DEFAULT;
+    parsers &= ~maddy::types::EMPHASIZED_PARSER; // disable emphasized parser
+    parsers |= maddy::types::HTML_PARSER; // do not wrap HTML in paragraph
+    return parsers;
+}
+}
 
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent)
     , ui(new Ui::MainWindow)
 {
+    m_startupTimer.start();
+    m_firstPreviewLogged = false;
+    m_previewParsesToTime = 0;
+
     ui->setupUi(this);
 
     m_lastEditorScrollRatio = 0.0;
+    m_previewParseGeneration = 0;
+    m_previewStale = false;
+    m_displayedRenderKey = 0;
+    m_executorPanel = nullptr;
 
     m_editorFontSize = 12;
     m_previewFontSize = 12;
@@ -50,27 +86,57 @@ MainWindow::MainWindow(QWidget *parent)
     mainLayout->setContentsMargins(0, 0, 0, 0);
 
     QSplitter *splitter = new QSplitter(Qt::Horizontal, this);
+    m_splitter = splitter;
+
+    // 編輯區與其左側標記邊欄放在同一個容器中
+    QWidget *editorPane = new QWidget(splitter);
+    QHBoxLayout *editorLayout = new QHBoxLayout(editorPane);
+    editorLayout->setContentsMargins(0, 0, 0, 0);
+    editorLayout->setSpacing(0);
 
     QFont baseFont("Arial", m_editorFontSize);
-    m_editor = new QTextEdit(splitter);
+    m_editor = new QTextEdit(editorPane);
     m_editor->setObjectName("editor");
     m_editor->setAutoFormatting(QTextEdit::AutoNone);
     m_editor->setFont(baseFont);
 
     m_highlighter = new MarkdownHighlighter(m_editor->document(), m_editor->font());
+    m_highlighter->setEditor(m_editor); // 大型文件優先標示可見區域
+
+    EditorGutter *gutter = new EditorGutter(m_editor, editorPane);
+    connect(m_highlighter, &MarkdownHighlighter::degradedBlocksChanged, gutter, QOverload<>::of(&QWidget::update));
+    editorLayout->addWidget(gutter);
+    editorLayout->addWidget(m_editor);
+
+    // 預覽引擎可在執行期切換 (檢視 > 預覽引擎)，設定保存在 QSettings
+    m_previewBackend = nullptr;
+    QSettings settings;
+    m_previewBackendType = settings.value(kPreviewBackendKey).toString() == "textbrowser"
+                           ? PreviewBackend::TextBrowser
+                           : PreviewBackend::WebEngine;
+    setPreviewBackend(m_previewBackendType);
+
+    m_inlineMemo = std::make_shared<maddy::InlineMemo>(
+        settings.value(kInlineMemoBytesKey, kDefaultInlineMemoBytes).toUInt());
 
-    m_preview = new QWebEngineView(splitter);
-    m_preview->setObjectName("preview");
-    //m_preview->page()->setBackgroundColor(Qt::transparent);
+    // 重新開啟未修改的檔案時，預覽與標示結果直接從磁碟快取還原
+    m_documentCache = std::make_shared<DocumentCache>(
+        DocumentCache::defaultDirectory(),
+        settings.value(kDocumentCacheBytesKey, kDefaultDocumentCacheBytes).toLongLong());
+    m_diskContentHash = 0;
+
+    // 編輯區第一次繪製後才初始化預覽引擎 (QtWebEngine 會啟動 Chromium)，視窗可以先出現並開始輸入
+    m_editor->viewport()->installEventFilter(this);
 
     mainLayout->addWidget(splitter);
+    // 窗格收合或展開時暫停或恢復對應的工作
+    connect(splitter, &QSplitter::splitterMoved, this, &MainWindow::updatePaneVisibility);
     QList<int> initialSizes;
     initialSizes << 600 << 600;
     splitter->setSizes(initialSizes);
 
     connect(m_editor, &QTextEdit::textChanged, this, &MainWindow::onTextChanged);
     connect(m_editor->document(), &QTextDocument::modificationChanged, this, &MainWindow::onDocumentModified);
-    connect(m_preview, &QWebEngineView::loadFinished, this, &MainWindow::onPreviewLoadFinished);
     m_previewUpdateTimer = new QTimer(this);
 
     m_previewUpdateTimer->setSingleShot(true); // 設定為單次觸發
@@ -136,20 +202,14 @@ void MainWindow::setupActions()
     QAction *editorZoomInAction = new QAction("放大編輯區", this);
     connect(editorZoomInAction, &QAction::triggered, this, [this]() {
         m_editorFontSize += 1; // 增加字號
-        QFont f = m_editor->font();
-        f.setPointSize(m_editorFontSize);
-        m_editor->setFont(f);
-        m_highlighter = new MarkdownHighlighter(m_editor->document(), f);
+        applyEditorFontSize();
     });
 
     QAction *editorZoomOutAction = new QAction("縮小編輯區", this);
     connect(editorZoomOutAction, &QAction::triggered, this, [this]() {
         if (m_editorFontSize > 8) {
             m_editorFontSize -= 1; // 減小字號
-            QFont f = m_editor->font();
-            f.setPointSize(m_editorFontSize);
-            m_editor->setFont(f);
-            m_highlighter = new MarkdownHighlighter(m_editor->document(), f);
+            applyEditorFontSize();
         }
     });
 
@@ -184,6 +244,92 @@ void MainWindow::setupActions()
     editToolBar->addAction(previewZoomInAction);
     editToolBar->addAction(previewZoomOutAction);
 
+    // --- 檢視功能表 ---
+    QMenu *viewMenu = menuBar()->addMenu("檢視(&V)");
+    QMenu *backendMenu = viewMenu->addMenu("預覽引擎");
+    QActionGroup *backendGroup = new QActionGroup(this);
+
+    QAction *webEngineAction = new QAction("完整 (QtWebEngine)", backendGroup);
+    webEngineAction->setCheckable(true);
+    webEngineAction->setChecked(m_previewBackendType == PreviewBackend::WebEngine);
+    connect(webEngineAction, &QAction::triggered, this, [this]() {
+        setPreviewBackend(PreviewBackend::WebEngine);
+    });
+
+    QAction *textBrowserAction = new QAction("輕量 (QTextBrowser，省記憶體)", backendGroup);
+    textBrowserAction->setCheckable(true);
+    textBrowserAction->setChecked(m_previewBackendType == PreviewBackend::TextBrowser);
+    connect(textBrowserAction, &QAction::triggered, this, [this]() {
+        setPreviewBackend(PreviewBackend::TextBrowser);
+    });
+
+    backendMenu->addAction(webEngineAction);
+    backendMenu->addAction(textBrowserAction);
+
+    // 除錯用：背景工作的排隊數與耗時
+    QAction *executorPanelAction = new QAction("背景工作狀態", this);
+    connect(executorPanelAction, &QAction::triggered, this, [this]() {
+        if (!m_executorPanel) {
+            m_executorPanel = new ExecutorPanel(this);
+            m_executorPanel->addStatsSource("預覽快取", [this]() {
+                return QString("命中率 %1% (命中 %2 / 未命中 %3)")
+                       .arg(qRound(m_renderCache.hitRate() * 100))
+                       .arg(m_renderCache.hits())
+                       .arg(m_renderCache.misses());
+            });
+            m_executorPanel->addStatsSource("行內快取", [this]() {
+                return QString("命中率 %1% (命中 %2 / 未命中 %3，%4 KB)")
+                       .arg(qRound(m_inlineMemo->HitRate() * 100))
+                       .arg(m_inlineMemo->Hits())
+                       .arg(m_inlineMemo->Misses())
+                       .arg(m_inlineMemo->UsedBytes() / 1024);
+            });
+        }
+        m_executorPanel->show();
+        m_executorPanel->raise();
+    });
+    viewMenu->addAction(executorPanelAction);
+}
+
+void MainWindow::setPreviewBackend(PreviewBackend::Type type)
+{
+    if (m_previewBackend && type == m_previewBackendType) {
+        return;
+    }
+
+    // 沿用原本的位置與寬度
+    bool replacing = m_previewBackend != nullptr;
+    int index = m_splitter->count();
+    QList<int> sizes = m_splitter->sizes();
+    if (replacing) {
+        index = m_splitter->indexOf(m_previewBackend->widget());
+        delete m_previewBackend; // 一併刪除元件；切到輕量模式時可釋放 Chromium 的記憶體
+    }
+
+    if (type == PreviewBackend::TextBrowser) {
+        m_previewBackend = new TextBrowserPreview(m_splitter, this);
+    } else {
+        m_previewBackend = new WebEnginePreview(m_splitter, this);
+    }
+    m_splitter->insertWidget(index, m_previewBackend->widget());
+    connect(m_previewBackend, &PreviewBackend::contentShown, this, [this]() {
+        if (!m_firstPreviewLogged) {
+            m_firstPreviewLogged = true;
+            qDebug() << "startup: first preview after" << m_startupTimer.elapsed() << "ms";
+        }
+    });
+    if (sizes.size() == m_splitter->count()) {
+        m_splitter->setSizes(sizes);
+    }
+
+    m_previewBackendType = type;
+    m_displayedRenderKey = 0;
+    QSettings settings;
+    settings.setValue(kPreviewBackendKey, type == PreviewBackend::TextBrowser ? "textbrowser" : "webengine");
+
+    if (replacing) {
+        onTextChanged(); // 以新的引擎重新渲染預覽
+    }
 }
 
 
@@ -202,6 +348,7 @@ void MainWindow::updateWindowTitle()
 }
 void MainWindow::newFile()
 {
+    storeDocumentCache();
     m_editor->clear();
     m_currentFilePath = "";
     updateWindowTitle();
@@ -215,21 +362,92 @@ void MainWindow::openFile()
         return;
     }
 
-    QFile file(filePath);
-    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
-        QMessageBox::warning(this, "錯誤", "無法開啟檔案: " + file.errorString());
+    // 讀檔與解碼交給背景工作，開啟大檔案時視窗不會凍結
+    QPointer<QObject> receiver(this);
+    std::shared_ptr<DocumentCache> documentCache = m_documentCache;
+    TaskExecutor::instance()->submit(TaskExecutor::Interactive, "file load",
+        [receiver, filePath, documentCache](const CancellationToken &) {
+            QFile file(filePath);
+            bool ok = file.open(QIODevice::ReadOnly | QIODevice::Text);
+            QString text;
+            QString error;
+            if (ok) {
+                QTextStream in(&file);
+                text = in.readAll();
+                file.close();
+            } else {
+                error = file.errorString();
+            }
+
+            quint64 contentHash = 0;
+            CachedDocument cached;
+            if (ok) {
+                QElapsedTimer timer;
+                timer.start();
+                contentHash = ContentHash().add(text).value();
+                if (documentCache->load(filePath, contentHash, cached)) {
+                    qDebug() << "document cache: loaded" << filePath << "in" << timer.elapsed() << "ms";
+                }
+            }
+            TaskExecutor::postToGui(receiver, [receiver, filePath, ok, text, error, contentHash, cached]() {
+                static_cast<MainWindow *>(receiver.data())->onFileLoaded(filePath, ok, text, error, contentHash, cached);
+            });
+        });
+}
+
+void MainWindow::onFileLoaded(const QString &filePath, bool ok, const QString &text, const QString &error,
+                              quint64 contentHash, const CachedDocument &cached)
+{
+    if (!ok) {
+        QMessageBox::warning(this, "錯誤", "無法開啟檔案: " + error);
         return;
     }
 
-    QTextStream in(&file);
-    m_editor->setText(in.readAll());
-    file.close();
+    // 先保存目前的文件，再換成新的
+    storeDocumentCache();
+
+    // 快取的結果要在 setPlainText 之前交出：標示在設定文字時就會進行，預覽則直接命中
+    if (cached.blocks) {
+        m_renderCache.insert(cached.renderKey, cached.blocks);
+    }
+    m_highlighter->preloadLines(cached.lines);
+
+    // 預熱只用了小範例，實際文件第一次轉換與標示的時間另外記錄
+    m_previewParsesToTime = kTimedParsesAfterLoad;
+    m_highlighter->timeNextBatches();
+
+    m_editor->setPlainText(text);
     m_editor->document()->setModified(false);
 
     m_currentFilePath = filePath;
+    m_diskContentHash = contentHash;
     updateWindowTitle();
 
+    if (cached.blocks) {
+        m_previewUpdateTimer->stop();
+        updatePreview();
+    }
+}
+
+void MainWindow::storeDocumentCache()
+{
+    // 只保存與磁碟上內容相同的文件，下次開啟時內容雜湊才會相符
+    if (m_currentFilePath.isEmpty() || m_editor->document()->isModified()) {
+        return;
+    }
 
+    CachedDocument document;
+    document.renderKey = RenderCache::key(m_editor->toPlainText(), previewParsers());
+    document.blocks = m_renderCache.peek(document.renderKey);
+    document.lines = m_highlighter->cachedLines();
+
+    std::shared_ptr<DocumentCache> documentCache = m_documentCache;
+    QString filePath = m_currentFilePath;
+    quint64 contentHash = m_diskContentHash;
+    TaskExecutor::instance()->submit(TaskExecutor::Background, "document cache store",
+        [documentCache, filePath, contentHash, document](const CancellationToken &) {
+            documentCache->store(filePath, contentHash, document);
+        });
 }
 
 bool MainWindow::saveFile()
@@ -245,9 +463,11 @@ bool MainWindow::saveFile()
         return false;
     }
 
+    QString text = m_editor->toPlainText();
     QTextStream out(&file);
-    out << m_editor->toPlainText();
+    out << text;
     file.close();
+    m_diskContentHash = ContentHash().add(text).value();
     m_editor->document()->setModified(false);
 
     updateWindowTitle();
@@ -272,6 +492,46 @@ void MainWindow::onDocumentModified()
     updateWindowTitle();
 }
 
+bool MainWindow::isPaneVisible(QWidget *pane) const
+{
+    // 收合的窗格寬度為 0，但仍是 visible
+    return isVisible() && !isMinimized() && pane->isVisible() && pane->width() > 0;
+}
+
+void MainWindow::updatePaneVisibility()
+{
+    m_highlighter->setSuspended(!isPaneVisible(m_editor->parentWidget()));
+
+    if (m_previewStale && isPaneVisible(m_previewBackend->widget())) {
+        updatePreview();
+    }
+}
+
+void MainWindow::changeEvent(QEvent *event)
+{
+    QMainWindow::changeEvent(event);
+    if (event->type() == QEvent::WindowStateChange) {
+        updatePaneVisibility();
+    }
+}
+
+bool MainWindow::eventFilter(QObject *watched, QEvent *event)
+{
+    if (watched == m_editor->viewport() && event->type() == QEvent::Paint) {
+        m_editor->viewport()->removeEventFilter(this);
+        qDebug() << "startup: first paint after" << m_startupTimer.elapsed() << "ms";
+
+        // 排到事件迴圈，讓這一個畫面先送到螢幕上
+        QTimer::singleShot(0, this, [this]() {
+            QElapsedTimer timer;
+            timer.start();
+            m_previewBackend->initialize();
+            qDebug() << "startup: preview backend initialized in" << timer.elapsed() << "ms";
+        });
+    }
+    return QMainWindow::eventFilter(watched, event);
+}
+
 void MainWindow::closeEvent(QCloseEvent *event)
 {
     // 檢查文件是否有未儲存的變更
@@ -300,6 +560,11 @@ void MainWindow::closeEvent(QCloseEvent *event)
         // 如果沒有未儲存的變更
         event->accept(); // 直接接受關閉事件
     }
+
+    // 結束時保存目前文件的結果；寫入在背景執行緒進行，QThreadPool 結束前會等它完成
+    if (event->isAccepted()) {
+        storeDocumentCache();
+    }
 }
 
 void MainWindow::applyEditorFontSize()
@@ -308,8 +573,8 @@ void MainWindow::applyEditorFontSize()
     font.setPointSize(m_editorFontSize);
     m_editor->setFont(font);
 
-    // 重新建立 Highlighter 以套用新的基礎字體
-    m_highlighter = new MarkdownHighlighter(m_editor->document(), font);
+    // 沿用同一個 Highlighter，只更新其基礎字體
+    m_highlighter->setBaseFont(font);
 }
 
 void MainWindow::setEditorFontSize()
@@ -350,6 +615,13 @@ void MainWindow::loadCssTemplate()
 // 在 mainwindow.cpp 末尾新增
 void MainWindow::updatePreview()
 {
+    // 預覽看不到時不轉換，等重新可見時再補做最新的一次
+    if (!isPaneVisible(m_previewBackend->widget())) {
+        m_previewStale = true;
+        return;
+    }
+    m_previewStale = false;
+
     QString markdownText = m_editor->toPlainText();
 
     QScrollBar *editorScrollBar = m_editor->verticalScrollBar();
@@ -358,32 +630,83 @@ void MainWindow::updatePreview()
         m_lastEditorScrollRatio = (double)editorScrollBar->value() / editorScrollBar->maximum();
     }
 
-    // 使用 maddy 引擎進行轉換
-    std::stringstream markdownStream(markdownText.toStdString());
-    std::shared_ptr<maddy::ParserConfig> config = std::make_shared<maddy::ParserConfig>();
-    config->enabledParsers &= ~maddy::types::EMPHASIZED_PARSER; // disable emphasized parser
-    config->enabledParsers |= maddy::types::HTML_PARSER; // do not wrap HTML in paragraph
-    std::shared_ptr<maddy::Parser> parser = std::make_shared<maddy::Parser>(config);
-    std::string htmlString = parser->Parse(markdownStream);
+    // 新的內容送出時取消尚未完成的舊轉換
+    m_previewParseToken.cancel();
+    quint64 generation = ++m_previewParseGeneration;
+
+    // 相同的文字與設定已轉換過：直接使用快取結果，完全不再轉換
+    const quint32 parsers = previewParsers();
+    const quint64 key = RenderCache::key(markdownText, parsers);
+    RenderCache::Blocks cached = m_renderCache.find(key);
+    if (cached) {
+        // 由快取還原時沒有第一次轉換，之後的轉換即為穩定狀態
+        if (m_previewParsesToTime == kTimedParsesAfterLoad) {
+            qDebug() << "load: first preview from render cache, no parse";
+            --m_previewParsesToTime;
+        }
+        onPreviewParsed(generation, key, cached);
+        return;
+    }
+
+    // 使用 maddy 引擎在背景進行轉換
+    std::string markdown = markdownText.toStdString();
+    // 重用編輯區 highlighter 已算好的行分類，避免預覽再掃描一次
+    // 行數或文字對不上時得到空的 vector，parser 會自行斷詞
+    std::vector<maddy::LineToken> lineTokens = m_highlighter->lineTokens(markdownText);
+    QPointer<QObject> receiver(this);
+    std::shared_ptr<maddy::InlineMemo> inlineMemo = m_inlineMemo;
+    const bool timed = m_previewParsesToTime > 0;
+    const bool firstAfterLoad = m_previewParsesToTime == kTimedParsesAfterLoad;
+    if (timed) {
+        --m_previewParsesToTime;
+    }
+
+    m_previewParseToken = TaskExecutor::instance()->submit(TaskExecutor::Interactive, "preview parse",
+        [receiver, generation, key, parsers, markdown, lineTokens, inlineMemo, timed,
+         firstAfterLoad](const CancellationToken &token) {
+            QElapsedTimer timer;
+            timer.start();
+            std::shared_ptr<maddy::ParserConfig> config = std::make_shared<maddy::ParserConfig>();
+            config->enabledParsers = parsers;
+            config->inlineMemo = inlineMemo;
+            std::shared_ptr<maddy::Parser> parser = std::make_shared<maddy::Parser>(config);
+            RenderCache::Blocks blocks =
+                std::make_shared<const std::vector<maddy::ParsedBlock>>(parser->ParseBlocks(markdown, &lineTokens));
+            if (timed) {
+                qDebug() << (firstAfterLoad ? "load: first preview parse" : "load: steady-state preview parse")
+                         << markdown.size() << "bytes in" << timer.nsecsElapsed() / 1000 << "us";
+            }
+            if (token.isCancelled()) {
+                return;
+            }
+            TaskExecutor::postToGui(receiver, [receiver, generation, key, blocks]() {
+                MainWindow *window = static_cast<MainWindow *>(receiver.data());
+                window->m_renderCache.insert(key, blocks);
+                window->onPreviewParsed(generation, key, blocks);
+            });
+        });
+}
+
+void MainWindow::onPreviewParsed(quint64 generation, quint64 key, const RenderCache::Blocks &blocks)
+{
+    // 已有更新的轉換送出，這份結果過時
+    if (generation != m_previewParseGeneration) {
+        return;
+    }
 
    // QString wrappedHtml = QString("<div id=\"wrapper\"><div>%1</div></div>")
    //                         .arg(QString::fromStdString(htmlString));
 
     // 組合 CSS 並顯示
     QString finalCss = m_cssTemplate.arg(m_previewFontSize).arg(m_previewFontSize - 2);
-    QString fullHtml = QString("<style>%1</style>").arg(finalCss)
-                       + QString::fromStdString(htmlString);
+    QString baseDirectory = m_currentFilePath.isEmpty() ? QString() : QFileInfo(m_currentFilePath).absolutePath();
 
-    m_preview->setHtml(fullHtml);
-}
-
-void MainWindow::onPreviewLoadFinished()
-{
-
-    QString script = QString(
-        "const scrollHeight = document.body.scrollHeight - window.innerHeight;"
-        "window.scrollTo(0, scrollHeight * %1);"
-    ).arg(m_lastEditorScrollRatio);
+    // 與目前顯示的內容完全相同 (例如計時器空轉) 時不重新載入
+    quint64 displayKey = ContentHash().add(key).add(finalCss).add(baseDirectory).value();
+    if (displayKey == m_displayedRenderKey) {
+        return;
+    }
+    m_displayedRenderKey = displayKey;
 
-    m_preview->page()->runJavaScript(script);
+    m_previewBackend->setContent(finalCss, *blocks, baseDirectory, m_lastEditorScrollRatio);
 }
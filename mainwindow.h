@@ -2,12 +2,25 @@
 #define MAINWINDOW_H
 
 #include <QMainWindow>
+#include <QElapsedTimer>
+
+#include <memory>
+
+#include "documentcache.h"
+#include "previewbackend.h"
+#include "rendercache.h"
+#include "taskexecutor.h"
 
 class QTextEdit;
-class QWebEngineView;
 class QCloseEvent;
 class QTimer;
+class QSplitter;
 class MarkdownHighlighter;
+class ExecutorPanel;
+
+namespace maddy {
+class InlineMemo;
+}
 
 QT_BEGIN_NAMESPACE
 namespace Ui { class MainWindow; }
@@ -27,7 +40,6 @@ private slots:
     void updatePreview();
     void setEditorFontSize();
     void setPreviewFontSize();
-    void onPreviewLoadFinished();
 
 public:
     MainWindow(QWidget *parent = nullptr);
@@ -38,11 +50,20 @@ private:
     void setupActions();
     void applyEditorFontSize();
     void loadCssTemplate();
+    void setPreviewBackend(PreviewBackend::Type type);
+    void onFileLoaded(const QString &filePath, bool ok, const QString &text, const QString &error,
+                      quint64 contentHash, const CachedDocument &cached);
+    void storeDocumentCache();
+    void onPreviewParsed(quint64 generation, quint64 key, const RenderCache::Blocks &blocks);
+    bool isPaneVisible(QWidget *pane) const;
+    void updatePaneVisibility();
 
 private:
     Ui::MainWindow *ui;
     QTextEdit *m_editor;
-    QWebEngineView *m_preview;
+    QSplitter *m_splitter;
+    PreviewBackend *m_previewBackend;
+    PreviewBackend::Type m_previewBackendType;
     QString m_currentFilePath;
     MarkdownHighlighter *m_highlighter;
     int m_editorFontSize;
@@ -50,9 +71,23 @@ private:
     QString m_cssTemplate;
     QTimer *m_previewUpdateTimer;
     qreal m_lastEditorScrollRatio;
+    CancellationToken m_previewParseToken;
+    quint64 m_previewParseGeneration;
+    bool m_previewStale; // 預覽看不到時略過了渲染，重新可見時要補做一次
+    RenderCache m_renderCache;
+    std::shared_ptr<maddy::InlineMemo> m_inlineMemo; // 所有預覽轉換共用，編輯後重新轉換時未改變的行直接取用
+    std::shared_ptr<DocumentCache> m_documentCache;  // 背景工作也持有一份
+    quint64 m_diskContentHash; // 目前檔案在磁碟上的內容雜湊 (開啟或儲存時的文字)
+    quint64 m_displayedRenderKey; // 目前顯示內容 (轉換結果、樣式、圖片目錄) 的雜湊，0 表示未知
+    ExecutorPanel *m_executorPanel;
+    QElapsedTimer m_startupTimer; // 啟動時間記錄：第一次繪製與第一次預覽
+    bool m_firstPreviewLogged;
+    int m_previewParsesToTime; // 開啟檔案後記錄前幾次轉換的時間 (第一次與之後的穩定狀態)
 
 protected:
     void closeEvent(QCloseEvent *event) override;
+    void changeEvent(QEvent *event) override;
+    bool eventFilter(QObject *watched, QEvent *event) override;
 };
 
 #endif // MAINWINDOW_H
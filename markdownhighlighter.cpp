@@ -1,11 +1,196 @@
 
 #include "markdownhighlighter.h"
+#include "contenthash.h"
 #include <QFont>
+#include <QTextEdit>
+#include <QScrollBar>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QDebug>
+
+namespace {
+// 區塊數超過此值才啟用延遲標示，小文件維持原本的同步行為
+const int kLazyBlockThreshold = 2000;
+// 可見範圍上下額外預先標示的區塊數
+const int kVisibleMargin = 50;
+// 每次事件迴圈最多花在背景標示的時間 (毫秒)
+const int kIdleSliceMs = 4;
+// 單一區塊預設的長度與時間上限，超過時只做結構性標示
+const int kDefaultMaxBlockLength = 5000;
+const int kDefaultMaxBlockMs = 8;
+// 開啟檔案後記錄時間的批次數：第一批，以及之後一批作為穩定狀態的對照
+const int kTimedBatchesAfterLoad = 2;
+}
 
 MarkdownHighlighter::MarkdownHighlighter(QTextDocument *parent, const QFont &baseFont)
     : QSyntaxHighlighter(parent)
+    , m_idleTimer(new QTimer(this))
+    , m_firstVisibleBlock(0)
+    , m_lastVisibleBlock(kVisibleMargin * 2)
+    , m_nextIdleBlock(0)
+    , m_forceHighlight(false)
+    , m_maxBlockLength(kDefaultMaxBlockLength)
+    , m_maxBlockMs(kDefaultMaxBlockMs)
+    , m_suspended(false)
+    , m_flushTimer(new QTimer(this))
+    , m_tokenizer(std::make_shared<HighlightTokenizer>())
+    , m_nextRequestId(0)
+    , m_revision(0)
+    , m_batchesToTime(0)
+    , m_preloadRemaining(0)
+{
+    m_idleTimer->setSingleShot(true);
+    m_idleTimer->setInterval(0);
+    connect(m_idleTimer, &QTimer::timeout, this, &MarkdownHighlighter::processPendingBlocks);
+
+    // 同一輪事件中累積的快照一次送往背景執行緒
+    m_flushTimer->setSingleShot(true);
+    m_flushTimer->setInterval(0);
+    connect(m_flushTimer, &QTimer::timeout, this, &MarkdownHighlighter::flushSnapshots);
+
+    // 斷詞交給共用的 TaskExecutor，GUI 執行緒只負責依 span 套用格式
+    std::shared_ptr<const HighlightTokenizer> tokenizer = m_tokenizer;
+    TaskExecutor::instance()->submit(TaskExecutor::Background, "highlighter warm-up",
+        [tokenizer](const CancellationToken &) {
+            tokenizer->warmUp();
+        });
+
+    buildFormats(baseFont);
+}
+
+MarkdownHighlighter::~MarkdownHighlighter()
+{
+    m_revisionToken.cancel();
+}
+
+void MarkdownHighlighter::setBlockBudget(int maxLength, int maxMilliseconds)
 {
-    HighlightingRule rule;
+    m_maxBlockLength = maxLength;
+    m_maxBlockMs = maxMilliseconds;
+
+    // 上限改變後既有的 span 快取全部失效，尚未完成的斷詞也不再需要
+    // (取消的工作不一定回傳每個區塊的結果，等待中的項目在此一併清除)
+    ++m_revision;
+    m_preloaded.clear();
+    m_preloadRemaining = 0;
+    m_revisionToken.cancel();
+    m_revisionToken = CancellationToken();
+    m_outgoing.clear();
+    m_inFlight.clear();
+    rehighlight();
+}
+
+void MarkdownHighlighter::setSuspended(bool suspended)
+{
+    if (m_suspended == suspended) {
+        return;
+    }
+
+    m_suspended = suspended;
+    if (suspended) {
+        m_idleTimer->stop();
+        return;
+    }
+
+    // 暫停期間延後的區塊：可見範圍立即補上，其餘交給閒置處理
+    onViewportChanged();
+    m_idleTimer->start();
+}
+
+void MarkdownHighlighter::setEditor(QTextEdit *editor)
+{
+    m_editor = editor;
+    if (!editor) {
+        return;
+    }
+
+    QScrollBar *scrollBar = editor->verticalScrollBar();
+    connect(scrollBar, &QScrollBar::valueChanged, this, &MarkdownHighlighter::onViewportChanged);
+    connect(scrollBar, &QScrollBar::rangeChanged, this, &MarkdownHighlighter::onViewportChanged);
+    onViewportChanged();
+}
+
+void MarkdownHighlighter::onViewportChanged()
+{
+    if (!m_editor || m_suspended) {
+        return;
+    }
+
+    // 找出目前可見的區塊範圍
+    int top = m_editor->cursorForPosition(QPoint(0, 0)).blockNumber();
+    int bottom = m_editor->cursorForPosition(QPoint(0, m_editor->viewport()->height())).blockNumber();
+    m_firstVisibleBlock = qMax(0, top - kVisibleMargin);
+    m_lastVisibleBlock = bottom + kVisibleMargin;
+
+    // 可見範圍內尚未標示的區塊立即補上
+    QTextBlock block = document()->findBlockByNumber(m_firstVisibleBlock);
+    m_forceHighlight = true;
+    while (block.isValid() && block.blockNumber() <= m_lastVisibleBlock) {
+        MarkdownBlockData *data = static_cast<MarkdownBlockData *>(block.userData());
+        if (data && data->isPending) {
+            rehighlightBlock(block);
+        }
+        block = block.next();
+    }
+    m_forceHighlight = false;
+
+    // 背景處理從可見範圍之後接續，讓使用者正在看的區域優先完成
+    m_nextIdleBlock = m_lastVisibleBlock + 1;
+}
+
+void MarkdownHighlighter::processPendingBlocks()
+{
+    QTextDocument *doc = document();
+    if (!doc || m_suspended) {
+        return;
+    }
+
+    QElapsedTimer elapsed;
+    elapsed.start();
+
+    int blockCount = doc->blockCount();
+    if (m_nextIdleBlock >= blockCount) {
+        m_nextIdleBlock = 0;
+    }
+
+    // 從 m_nextIdleBlock 開始繞行整份文件一次，時間用完就讓出事件迴圈
+    QTextBlock block = doc->findBlockByNumber(m_nextIdleBlock);
+    int scanned = 0;
+    m_forceHighlight = true;
+    while (scanned < blockCount) {
+        if (!block.isValid()) {
+            block = doc->firstBlock();
+        }
+
+        MarkdownBlockData *data = static_cast<MarkdownBlockData *>(block.userData());
+        if (data && data->isPending) {
+            rehighlightBlock(block);
+            if (elapsed.elapsed() >= kIdleSliceMs) {
+                m_nextIdleBlock = block.blockNumber() + 1;
+                m_forceHighlight = false;
+                m_idleTimer->start();
+                return;
+            }
+        }
+
+        block = block.next();
+        ++scanned;
+    }
+    m_forceHighlight = false;
+    m_nextIdleBlock = 0;
+}
+
+void MarkdownHighlighter::setBaseFont(const QFont &baseFont)
+{
+    // 只重建格式表，並由同一個 highlighter 重新套用一次，
+    // 不再為每次縮放建立新的 highlighter；快取的 span 只存格式編號，不需重新斷詞
+    buildFormats(baseFont);
+    rehighlight();
+}
+
+void MarkdownHighlighter::buildFormats(const QFont &baseFont)
+{
+    m_formats.fill(QTextCharFormat(), FormatCount);
 
     // --- 基礎格式 ---
     // 預設文字使用基礎字體
@@ -20,9 +205,7 @@ MarkdownHighlighter::MarkdownHighlighter(QTextDocument *parent, const QFont &bas
     headingFont1.setPointSize(baseFont.pointSize() * 1.6);
     headingFormat1.setFont(headingFont1);
     headingFormat1.setForeground(QColor(135, 206, 250)); // 淡藍色
-    rule.pattern = QRegularExpression("^(#{1}\\s.*)");
-    rule.format = headingFormat1;
-    m_highlightingRules.append(rule);
+    m_formats[FormatHeading1] = headingFormat1;
 
     // 1.2 標題 (例如 # ## ###)
     QTextCharFormat headingFormat2;
@@ -31,9 +214,7 @@ MarkdownHighlighter::MarkdownHighlighter(QTextDocument *parent, const QFont &bas
     headingFont2.setPointSize(baseFont.pointSize() * 1.5);
     headingFormat2.setFont(headingFont2);
     headingFormat2.setForeground(QColor(135, 206, 250)); // 淡藍色
-    rule.pattern = QRegularExpression("^(#{2}\\s.*)");
-    rule.format = headingFormat2;
-    m_highlightingRules.append(rule);
+    m_formats[FormatHeading2] = headingFormat2;
 
     // 1.3 標題 (例如 # ## ###)
     QTextCharFormat headingFormat3;
@@ -42,9 +223,7 @@ MarkdownHighlighter::MarkdownHighlighter(QTextDocument *parent, const QFont &bas
     headingFont3.setPointSize(baseFont.pointSize() * 1.4);
     headingFormat3.setFont(headingFont3);
     headingFormat3.setForeground(QColor(135, 206, 250)); // 淡藍色
-    rule.pattern = QRegularExpression("^(#{3}\\s.*)");
-    rule.format = headingFormat3;
-    m_highlightingRules.append(rule);
+    m_formats[FormatHeading3] = headingFormat3;
 
     // 1.4 標題 (例如 # ## ###)
     QTextCharFormat headingFormat4;
@@ -53,9 +232,7 @@ MarkdownHighlighter::MarkdownHighlighter(QTextDocument *parent, const QFont &bas
     headingFont4.setPointSize(baseFont.pointSize() * 1.3);
     headingFormat4.setFont(headingFont4);
     headingFormat4.setForeground(QColor(135, 206, 250)); // 淡藍色
-    rule.pattern = QRegularExpression("^(#{4}\\s.*)");
-    rule.format = headingFormat4;
-    m_highlightingRules.append(rule);
+    m_formats[FormatHeading4] = headingFormat4;
 
     // 1.5 標題 (例如 # ## ###)
     QTextCharFormat headingFormat5;
@@ -64,9 +241,7 @@ MarkdownHighlighter::MarkdownHighlighter(QTextDocument *parent, const QFont &bas
     headingFont5.setPointSize(baseFont.pointSize() * 1.2);
     headingFormat5.setFont(headingFont5);
     headingFormat5.setForeground(QColor(135, 206, 250)); // 淡藍色
-    rule.pattern = QRegularExpression("^(#{5}\\s.*)");
-    rule.format = headingFormat5;
-    m_highlightingRules.append(rule);
+    m_formats[FormatHeading5] = headingFormat5;
 
     // 1.6 標題 (例如 # ## ###)
     QTextCharFormat headingFormat6;
@@ -75,9 +250,7 @@ MarkdownHighlighter::MarkdownHighlighter(QTextDocument *parent, const QFont &bas
     headingFont6.setPointSize(baseFont.pointSize() * 1.1);
     headingFormat6.setFont(headingFont6);
     headingFormat6.setForeground(QColor(135, 206, 250)); // 淡藍色
-    rule.pattern = QRegularExpression("^(#{6}\\s.*)");
-    rule.format = headingFormat6;
-    m_highlightingRules.append(rule);
+    m_formats[FormatHeading6] = headingFormat6;
 
     // 2. 粗體 (例如 **文字** 或 __文字__)
     QTextCharFormat boldFormat;
@@ -85,9 +258,7 @@ MarkdownHighlighter::MarkdownHighlighter(QTextDocument *parent, const QFont &bas
     boldFont.setBold(true);
     boldFont.setPointSize(baseFont.pointSize());
     boldFormat.setFont(boldFont);
-    rule.pattern = QRegularExpression("(\\*\\*|__)(.*?)\\1");
-    rule.format = boldFormat;
-    m_highlightingRules.append(rule);
+    m_formats[FormatBold] = boldFormat;
 
     // 3. 斜體 (例如 *文字* 或 _文字_)
     QTextCharFormat italicFormat;
@@ -95,9 +266,7 @@ MarkdownHighlighter::MarkdownHighlighter(QTextDocument *parent, const QFont &bas
     italicFont.setItalic(true);
     italicFont.setPointSize(baseFont.pointSize());
     italicFormat.setFont(italicFont);
-    rule.pattern = QRegularExpression("(?<!\\*)\\*(?!\\*|_)(.*?)(?<!_)\\*(?!\\*)|(?<!_)_{(?!_)(.*?)(?<!_)_{(?!_)");
-    rule.format = italicFormat;
-    m_highlightingRules.append(rule);
+    m_formats[FormatItalic] = italicFormat;
 
     // 4. 程式碼區塊分隔符 (例如 ```)
     QTextCharFormat codeBlockFormat;
@@ -106,9 +275,7 @@ MarkdownHighlighter::MarkdownHighlighter(QTextDocument *parent, const QFont &bas
     codeBlockFormat.setForeground(Qt::gray);
     codeBlockFont.setFamily("Consolas");
     codeBlockFont.setPointSize(baseFont.pointSize());
-    rule.pattern = QRegularExpression("```");
-    rule.format = codeBlockFormat;
-    m_highlightingRules.append(rule);
+    m_formats[FormatCodeFence] = codeBlockFormat;
 
     // 5. 清單 (例如 - item 或 1. item)
     QTextCharFormat listFormat;
@@ -116,9 +283,7 @@ MarkdownHighlighter::MarkdownHighlighter(QTextDocument *parent, const QFont &bas
     listFont.setBold(true);
     listFormat.setFont(listFont);
     listFormat.setForeground(QColor(255, 165, 0)); // 橘色
-    rule.pattern = QRegularExpression("^\\s*([\\*\\+\\-]\\s|\\d+\\.\\s.*)");
-    rule.format = listFormat;
-    m_highlightingRules.append(rule);
+    m_formats[FormatList] = listFormat;
 
     // 6. 行內程式碼 (例如 `code`)
     QTextCharFormat inlineCodeFormat;
@@ -127,9 +292,7 @@ MarkdownHighlighter::MarkdownHighlighter(QTextDocument *parent, const QFont &bas
     codeFont.setPointSize(baseFont.pointSize() * 0.9); // 程式碼字號略小一些
     inlineCodeFormat.setFont(codeFont);
     inlineCodeFormat.setBackground(QColor(230, 230, 230));
-    rule.pattern = QRegularExpression("`([^`].*?)`");
-    rule.format = inlineCodeFormat;
-    m_highlightingRules.append(rule);
+    m_formats[FormatInlineCode] = inlineCodeFormat;
 
     // 7. 引用 (例如 > quote)
     QTextCharFormat blockquoteFormat;
@@ -137,9 +300,7 @@ MarkdownHighlighter::MarkdownHighlighter(QTextDocument *parent, const QFont &bas
     bqFont.setItalic(true);
     blockquoteFormat.setFont(bqFont);
     blockquoteFormat.setForeground(Qt::darkGray);
-    rule.pattern = QRegularExpression("^>.*");
-    rule.format = blockquoteFormat;
-    m_highlightingRules.append(rule);
+    m_formats[FormatBlockquote] = blockquoteFormat;
 
     // 8. 連結文字 (例如 [Google])
     QTextCharFormat linkTextFormat;
@@ -147,32 +308,286 @@ MarkdownHighlighter::MarkdownHighlighter(QTextDocument *parent, const QFont &bas
     linkFont.setUnderline(true);
     linkTextFormat.setFont(linkFont);
     linkTextFormat.setForeground(Qt::blue);
-    rule.pattern = QRegularExpression("\\[([^\\]]+)\\]");
-    rule.format = linkTextFormat;
-    m_highlightingRules.append(rule);
+    m_formats[FormatLinkText] = linkTextFormat;
 
     // 9. 連結 URL (例如 (https://...))
     QTextCharFormat linkUrlFormat;
     linkUrlFormat.setFont(baseFont);
     linkUrlFormat.setForeground(Qt::gray);
-    rule.pattern = QRegularExpression("\\(([^\\)]+)\\)");
-    rule.format = linkUrlFormat;
-    m_highlightingRules.append(rule);
+    m_formats[FormatLinkUrl] = linkUrlFormat;
 }
 
 
 void MarkdownHighlighter::highlightBlock(const QString &text)
 {
-    // 遍歷我們定義的所有規則
-    for (const HighlightingRule &rule : m_highlightingRules) {
-        // 在目前的文字行中，尋找所有匹配規則的子字串
-        QRegularExpressionMatchIterator matchIterator = rule.pattern.globalMatch(text);
-        while (matchIterator.hasNext()) {
-            QRegularExpressionMatch match = matchIterator.next();
-            // 為匹配到的子字串套用格式
-            // match.capturedStart() 是子字串的起始位置
-            // match.capturedLength() 是子字串的長度
-            setFormat(match.capturedStart(), match.capturedLength(), rule.format);
+    // 磁碟快取的結果只需套用格式，成本與延後標示差不多，直接完成
+    if (applyPreloadedLine(text)) {
+        return;
+    }
+
+    if (shouldDeferCurrentBlock()) {
+        // 不在可見範圍內：先記下，交給閒置時的背景處理
+        markCurrentBlockPending(true);
+        currentBlockData(true)->isCurrent = false;
+        if (!m_idleTimer->isActive() && !m_suspended) {
+            m_idleTimer->start();
         }
+        return;
+    }
+
+    markCurrentBlockPending(false);
+
+    // 內容雜湊相同的區塊直接套用快取的 span，不再重新斷詞
+    MarkdownBlockData *data = currentBlockData(true);
+    if (data->hasSpans && data->revision == m_revision && data->hash == qHash(text)) {
+        applySpans(data->spans, text.length());
+        return;
+    }
+
+    // 快取失效：先沿用舊的 span 避免閃爍，再交給背景執行緒重新斷詞
+    data->isCurrent = false;
+    applySpans(data->spans, text.length());
+    requestTokenization(data, text);
+}
+
+bool MarkdownHighlighter::applyPreloadedLine(const QString &text)
+{
+    const int number = currentBlock().blockNumber();
+    if (number >= m_preloaded.size() || !m_preloaded.at(number).hasSpans) {
+        return false;
+    }
+
+    // 載入後已被編輯而行號錯開的行，雜湊不會相符，照一般流程斷詞
+    CachedLine &line = m_preloaded[number];
+    if (line.textHash != ContentHash().add(text).value()) {
+        return false;
+    }
+
+    MarkdownBlockData *data = currentBlockData(true);
+    data->isPending = false;
+    data->spans = line.spans;
+    data->lineToken = line.lineToken;
+    data->textHash = line.textHash;
+    data->hash = qHash(text);
+    data->revision = m_revision;
+    data->hasSpans = true;
+    data->isCurrent = true;
+    if (data->isDegraded != line.degraded) {
+        data->isDegraded = line.degraded;
+        emit degradedBlocksChanged();
+    }
+    applySpans(data->spans, text.length());
+
+    line.hasSpans = false;
+    line.spans.clear();
+    if (--m_preloadRemaining == 0) {
+        m_preloaded.clear();
+    }
+    return true;
+}
+
+void MarkdownHighlighter::preloadLines(const QVector<CachedLine> &lines)
+{
+    m_preloaded = lines;
+    m_preloadRemaining = 0;
+    for (const CachedLine &line : lines) {
+        if (line.hasSpans) {
+            ++m_preloadRemaining;
+        }
+    }
+    if (m_preloadRemaining == 0) {
+        m_preloaded.clear();
+    }
+}
+
+void MarkdownHighlighter::timeNextBatches()
+{
+    m_batchesToTime = kTimedBatchesAfterLoad;
+}
+
+QVector<CachedLine> MarkdownHighlighter::cachedLines() const
+{
+    QVector<CachedLine> lines;
+    QTextDocument *doc = document();
+    if (!doc) {
+        return lines;
+    }
+
+    lines.reserve(doc->blockCount());
+    for (QTextBlock block = doc->firstBlock(); block.isValid(); block = block.next()) {
+        const MarkdownBlockData *data = static_cast<const MarkdownBlockData *>(block.userData());
+        CachedLine line;
+        if (data && data->isCurrent && data->revision == m_revision) {
+            line.textHash = ContentHash().add(block.text()).value();
+            line.hasSpans = true;
+            line.degraded = data->isDegraded;
+            line.lineToken = data->lineToken;
+            line.spans = data->spans;
+        }
+        lines.append(line);
+    }
+    return lines;
+}
+
+void MarkdownHighlighter::applySpans(const QVector<HighlightSpan> &spans, int textLength)
+{
+    for (const HighlightSpan &span : spans) {
+        if (span.start >= textLength) {
+            continue;
+        }
+        setFormat(span.start, qMin(span.length, textLength - span.start), m_formats.at(span.formatId));
+    }
+}
+
+void MarkdownHighlighter::requestTokenization(MarkdownBlockData *data, const QString &text)
+{
+    // 同一區塊先前的請求已被取代，其結果回來時也會被丟棄
+    m_inFlight.remove(data->requestId);
+    data->requestId = ++m_nextRequestId;
+    m_inFlight.insert(data->requestId, currentBlock());
+    m_outgoing.append({data->requestId, m_revision, text});
+    if (!m_flushTimer->isActive()) {
+        m_flushTimer->start();
+    }
+}
+
+void MarkdownHighlighter::flushSnapshots()
+{
+    if (m_outgoing.isEmpty()) {
+        return;
+    }
+    std::shared_ptr<const HighlightTokenizer> tokenizer = m_tokenizer;
+    QVector<BlockSnapshot> snapshots = m_outgoing;
+    int maxLength = m_maxBlockLength;
+    int maxMilliseconds = m_maxBlockMs;
+    CancellationToken revisionToken = m_revisionToken;
+    QPointer<QObject> receiver(this);
+    m_outgoing.clear();
+    const bool timed = m_batchesToTime > 0;
+    const bool firstAfterLoad = m_batchesToTime == kTimedBatchesAfterLoad;
+    if (timed) {
+        --m_batchesToTime;
+    }
+
+    TaskExecutor::instance()->submit(TaskExecutor::Visible, "highlight tokenize",
+        [=](const CancellationToken &) {
+            QElapsedTimer timer;
+            timer.start();
+            QVector<TokenizedBlock> results = tokenizer->tokenizeBlocks(snapshots, maxLength, maxMilliseconds,
+                                                                        revisionToken);
+            if (timed) {
+                qDebug() << (firstAfterLoad ? "load: first highlight batch" : "load: steady-state highlight batch")
+                         << snapshots.size() << "blocks in" << timer.nsecsElapsed() / 1000 << "us";
+            }
+            TaskExecutor::postToGui(receiver, [receiver, results]() {
+                static_cast<MarkdownHighlighter *>(receiver.data())->onBlocksTokenized(results);
+            });
+        });
+}
+
+void MarkdownHighlighter::onBlocksTokenized(const QVector<TokenizedBlock> &results)
+{
+    m_forceHighlight = true;
+    for (const TokenizedBlock &result : results) {
+        QTextBlock block = m_inFlight.take(result.requestId);
+
+        // 區塊已被刪除、內容又變動過或上限已更改時，丟棄這份結果
+        if (!block.isValid() || result.revision != m_revision) {
+            continue;
+        }
+        MarkdownBlockData *data = static_cast<MarkdownBlockData *>(block.userData());
+        if (!data || data->requestId != result.requestId) {
+            continue;
+        }
+
+        data->spans = result.spans;
+        data->lineToken = result.lineToken;
+        data->textHash = result.textHash;
+        data->hash = result.hash;
+        data->revision = result.revision;
+        data->hasSpans = true;
+        data->isCurrent = true;
+        if (data->isDegraded != result.degraded) {
+            data->isDegraded = result.degraded;
+            emit degradedBlocksChanged();
+        }
+        rehighlightBlock(block);
+    }
+    m_forceHighlight = false;
+}
+
+std::vector<maddy::LineToken> MarkdownHighlighter::lineTokens(const QString &plainText) const
+{
+    std::vector<maddy::LineToken> tokens;
+    QTextDocument *doc = document();
+    if (!doc) {
+        return tokens;
+    }
+
+    // toPlainText() 會把區塊內的 U+2028 (Shift+Enter) 等換成 '\n'，
+    // 這時區塊與行不再一一對應，整份捨棄，由 parser 自行判斷
+    if (plainText.count(QLatin1Char('\n')) + 1 != doc->blockCount()) {
+        return tokens;
+    }
+
+    // 尚未標示、內容已變動或文字雜湊不符的行保留預設值 (isKnown == false)
+    tokens.resize(static_cast<size_t>(doc->blockCount()));
+    const QChar *chars = plainText.constData();
+    int lineStart = 0;
+    size_t index = 0;
+    for (QTextBlock block = doc->firstBlock(); block.isValid() && index < tokens.size(); block = block.next(), ++index) {
+        int lineEnd = plainText.indexOf(QLatin1Char('\n'), lineStart);
+        if (lineEnd < 0) {
+            lineEnd = plainText.size();
+        }
+        const MarkdownBlockData *data = static_cast<const MarkdownBlockData *>(block.userData());
+        if (data && data->isCurrent && data->revision == m_revision
+            && data->textHash == ContentHash().add(chars + lineStart, static_cast<size_t>(lineEnd - lineStart) * sizeof(QChar)).value()) {
+            tokens[index] = data->lineToken;
+        }
+        lineStart = lineEnd + 1;
+    }
+    return tokens;
+}
+
+bool MarkdownHighlighter::shouldDeferCurrentBlock() const
+{
+    if (m_forceHighlight || !m_editor) {
+        return false;
+    }
+
+    if (!m_suspended && document()->blockCount() < kLazyBlockThreshold) {
+        return false;
+    }
+
+    // 游標所在的區塊 (正在輸入的那一行) 一律立即標示
+    const QTextBlock block = currentBlock();
+    if (block == m_editor->textCursor().block()) {
+        return false;
+    }
+
+    if (m_suspended) {
+        return true;
+    }
+
+    int number = block.blockNumber();
+    return number < m_firstVisibleBlock || number > m_lastVisibleBlock;
+}
+
+MarkdownBlockData *MarkdownHighlighter::currentBlockData(bool create)
+{
+    MarkdownBlockData *data = static_cast<MarkdownBlockData *>(currentBlockUserData());
+    if (!data && create) {
+        data = new MarkdownBlockData;
+        setCurrentBlockUserData(data);
+    }
+    return data;
+}
+
+void MarkdownHighlighter::markCurrentBlockPending(bool pending)
+{
+    MarkdownBlockData *data = currentBlockData(pending);
+    if (data) {
+        data->isPending = pending;
     }
 }
@@ -6,6 +6,34 @@
 #include <QSyntaxHighlighter>
 #include <QRegularExpression> // 引入規則運算式類別
 #include <QTextCharFormat>    // 引入文字格式類別
+#include <QTextBlockUserData>
+#include <QTextBlock>
+#include <QPointer>
+#include <QHash>
+#include <memory>
+#include <vector>
+
+#include "highlighttokenizer.h"
+#include "taskexecutor.h"
+
+class QTextEdit;
+class QTimer;
+
+// 每個文字區塊附帶的資料：標示狀態，以及以內容雜湊為鍵的 span 快取
+class MarkdownBlockData : public QTextBlockUserData
+{
+public:
+    bool isPending = false;
+    bool isDegraded = false;
+    bool hasSpans = false;
+    bool isCurrent = false;       // span 與 lineToken 是否對應目前的文字
+    uint hash = 0;
+    quint64 textHash = 0;         // 產生 lineToken 的文字的 ContentHash
+    int revision = 0;
+    quint64 requestId = 0;
+    QVector<HighlightSpan> spans;
+    maddy::LineToken lineToken;
+};
 
 class MarkdownHighlighter : public QSyntaxHighlighter
 {
@@ -14,19 +42,82 @@ class MarkdownHighlighter : public QSyntaxHighlighter
 public:
 
     MarkdownHighlighter(QTextDocument *parent,const  QFont &baseFont);
+    ~MarkdownHighlighter();
+
+    // 以新的基礎字體重建所有格式，並重新標示整份文件一次
+    void setBaseFont(const QFont &baseFont);
+
+    // 綁定編輯器後，大型文件只會立即標示可見區塊，其餘在閒置時分段處理
+    void setEditor(QTextEdit *editor);
+
+    // 單一區塊的長度 (字元) 與時間 (毫秒) 上限，0 表示不限制
+    void setBlockBudget(int maxLength, int maxMilliseconds);
+
+    // 編輯區看不到時 (視窗最小化、窗格收合) 暫停標示，只保留游標所在的行；
+    // 恢復後從可見範圍開始補上
+    void setSuspended(bool suspended);
+
+    // 依行號排列的行結構分類，讓預覽的 maddy::Parser 不必重新掃描已標示過的行
+    // plainText 必須是 document 的 toPlainText()；行數或任一行的文字對不上時回傳空的 vector
+    std::vector<maddy::LineToken> lineTokens(const QString &plainText) const;
+
+    // 開啟檔案時由磁碟快取提供的標示結果 (依行號排列)，文字雜湊相符的行直接套用，不再斷詞
+    void preloadLines(const QVector<CachedLine> &lines);
+
+    // 目前每一行的標示結果，供寫入磁碟快取；尚未標示或已過時的行 hasSpans 為 false
+    QVector<CachedLine> cachedLines() const;
+
+    // 開啟檔案時呼叫：記錄接下來第一批與下一批 (穩定狀態) 斷詞的時間
+    void timeNextBatches();
+
+signals:
+
+    void degradedBlocksChanged();
 
 protected:
 
     void highlightBlock(const QString &text) override;
 
+private slots:
+
+    void onViewportChanged();
+    void processPendingBlocks();
+    void flushSnapshots();
+    void onBlocksTokenized(const QVector<TokenizedBlock> &results);
+
 private:
 
-    struct HighlightingRule
-    {
-        QRegularExpression pattern; // 規則運算式
-        QTextCharFormat format;     // 對應的格式
-    };
-    QVector<HighlightingRule> m_highlightingRules; // 儲存所有規則的向量
+    void buildFormats(const QFont &baseFont);
+    void applySpans(const QVector<HighlightSpan> &spans, int textLength);
+    void requestTokenization(MarkdownBlockData *data, const QString &text);
+    bool shouldDeferCurrentBlock() const;
+    MarkdownBlockData *currentBlockData(bool create);
+    void markCurrentBlockPending(bool pending);
+    bool applyPreloadedLine(const QString &text);
+
+    QVector<QTextCharFormat> m_formats; // 以格式編號索引的格式表
+
+    QPointer<QTextEdit> m_editor;
+    QTimer *m_idleTimer;
+    int m_firstVisibleBlock;
+    int m_lastVisibleBlock;
+    int m_nextIdleBlock;
+    bool m_forceHighlight;
+    int m_maxBlockLength;
+    int m_maxBlockMs;
+    bool m_suspended;
+
+    QTimer *m_flushTimer;
+    std::shared_ptr<const HighlightTokenizer> m_tokenizer; // 執行中的工作也持有一份，避免提早釋放
+    CancellationToken m_revisionToken;      // 目前 revision 送出的工作共用，revision 改變時取消
+    QVector<BlockSnapshot> m_outgoing;      // 尚未送出的快照
+    QHash<quint64, QTextBlock> m_inFlight;  // 送出後等待結果的區塊
+    quint64 m_nextRequestId;
+    int m_revision;
+    int m_batchesToTime;
+
+    QVector<CachedLine> m_preloaded; // 每行只會套用一次，全部用完後釋放
+    int m_preloadRemaining;
 };
 
 #endif // MARKDOWNHIGHLIGHTER_H
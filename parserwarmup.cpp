@@ -0,0 +1,67 @@
+#include "parserwarmup.h"
+#include "taskexecutor.h"
+#include "maddy/parser.h"
+
+#include <QDebug>
+#include <QElapsedTimer>
+
+#include <memory>
+#include <sstream>
+
+namespace {
+// 涵蓋所有區塊與行內語法 (含巢狀清單)，確保每個 parser 的 regex 都會被用到
+const char kWarmUpSample[] =
+    "# h1\n## h2\n### h3\n#### h4\n##### h5\n###### h6\n"
+    "\n"
+    "paragraph with **strong**, __strong__, *italic*, _emphasized_, ~~strike~~,\n"
+    "`inline code`, [link](http://example.com) and ![image](image.png)\n"
+    "line break  \n"
+    "\n"
+    "```cpp\nint main() {}\n```\n"
+    "\n"
+    "$$x^2\n$$\n"
+    "\n"
+    "> quote\n> > nested\n"
+    "\n"
+    "* item\n  * child\n    1. ordered child\n* item\n"
+    "\n"
+    "1. first\n2. second\n   * child\n"
+    "\n"
+    "- [ ] open\n- [x] done\n"
+    "\n"
+    "---\n"
+    "\n"
+    "|table>\nh1 | h2\n- | -\na | b\n|<table\n"
+    "\n"
+    "<div>html</div>\n";
+
+void warmUpParser()
+{
+    std::shared_ptr<maddy::ParserConfig> config = std::make_shared<maddy::ParserConfig>();
+    config->enabledParsers = maddy::types::ALL;
+    maddy::Parser parser(config);
+
+    // 第一次包含 regex 編譯，第二次即為之後每次編輯的穩定狀態
+    QElapsedTimer timer;
+    timer.start();
+    std::stringstream cold(kWarmUpSample);
+    parser.Parse(cold);
+    qint64 coldNs = timer.nsecsElapsed();
+
+    timer.restart();
+    std::stringstream warm(kWarmUpSample);
+    parser.Parse(warm);
+    qint64 warmNs = timer.nsecsElapsed();
+
+    qDebug() << "startup: parser warm-up" << coldNs / 1000 << "us, steady-state parse"
+             << warmNs / 1000 << "us";
+}
+}
+
+void ParserWarmUp::start()
+{
+    TaskExecutor::instance()->submit(TaskExecutor::Background, "parser warm-up",
+        [](const CancellationToken &) {
+            warmUpParser();
+        });
+}
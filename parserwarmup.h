@@ -0,0 +1,16 @@
+// parserwarmup.h
+
+#ifndef PARSERWARMUP_H
+#define PARSERWARMUP_H
+
+// 啟動時在背景執行緒先跑一次 maddy::Parser，讓各 parser 內的 static std::regex
+// 在 GUI 執行緒第一次用到之前就已經編譯好，第一次輸入不會特別慢
+class ParserWarmUp
+{
+public:
+
+    // 排入 TaskExecutor 後立即返回
+    static void start();
+};
+
+#endif // PARSERWARMUP_H
@@ -0,0 +1,172 @@
+/* 虛擬化預覽 - preview_virtual.js
+ * 只把可見範圍 (加上前後各一個畫面) 的區塊放進 DOM，
+ * 其餘以估計高度的空白元素代替，捲動時再向 mdpreview://doc/blocks 取回片段。
+ */
+var mdv = (function () {
+    var MARGIN = 1.0;          /* 可見範圍前後各保留幾個畫面高度 */
+    var LINE_HEIGHT = 24;      /* 估計每行 markdown 的高度 (px) */
+    var BLOCK_SPACING = 16;
+
+    var generation = 0;
+    var count = 0;
+    var heights = [];
+    var offsets = [];
+    var htmlCache = {};
+    var renderedFrom = -1;
+    var renderedTo = -1;
+    var pendingRequest = null;
+    var scheduled = false;
+    var topSpacer, container, bottomSpacer;
+
+    function rebuildOffsets() {
+        offsets = new Array(count + 1);
+        offsets[0] = 0;
+        for (var i = 0; i < count; ++i) {
+            offsets[i + 1] = offsets[i] + heights[i];
+        }
+    }
+
+    function indexAt(y) {
+        var lo = 0, hi = count - 1;
+        while (lo < hi) {
+            var mid = (lo + hi + 1) >> 1;
+            if (offsets[mid] <= y) {
+                lo = mid;
+            } else {
+                hi = mid - 1;
+            }
+        }
+        return lo;
+    }
+
+    function request(from, to) {
+        if (pendingRequest) {
+            return;
+        }
+        pendingRequest = document.createElement('script');
+        pendingRequest.src = 'blocks?v=' + generation + '&from=' + from + '&to=' + to;
+        pendingRequest.onerror = function () {
+            pendingRequest.remove();
+            pendingRequest = null;
+        };
+        document.head.appendChild(pendingRequest);
+    }
+
+    function render(from, to) {
+        /* 以第一個可見區塊為錨點，重新排版後維持它在畫面上的位置 */
+        var anchor = indexAt(window.scrollY);
+        var anchorDelta = window.scrollY - offsets[anchor];
+
+        var parts = [];
+        for (var i = from; i <= to; ++i) {
+            parts.push('<div class="mdv-block">' + htmlCache[i] + '</div>');
+        }
+        container.innerHTML = parts.join('');
+
+        /* 以實際高度取代估計值 */
+        var children = container.children;
+        for (var k = 0; k < children.length; ++k) {
+            heights[from + k] = children[k].offsetHeight;
+        }
+        rebuildOffsets();
+
+        topSpacer.style.height = offsets[from] + 'px';
+        bottomSpacer.style.height = (offsets[count] - offsets[to + 1]) + 'px';
+
+        /* 只保留已放入 DOM 的片段，其餘交還給 C++ 端的記憶體 */
+        for (var key in htmlCache) {
+            if (key < from || key > to) {
+                delete htmlCache[key];
+            }
+        }
+
+        renderedFrom = from;
+        renderedTo = to;
+        window.scrollTo(0, offsets[anchor] + anchorDelta);
+    }
+
+    function update() {
+        scheduled = false;
+        if (count === 0) {
+            return;
+        }
+
+        var viewTop = window.scrollY;
+        var viewHeight = window.innerHeight;
+        var from = indexAt(Math.max(0, viewTop - viewHeight * MARGIN));
+        var to = indexAt(viewTop + viewHeight * (1 + MARGIN));
+
+        if (from >= renderedFrom && to <= renderedTo) {
+            return;
+        }
+
+        var missingFrom = -1, missingTo = -1;
+        for (var i = from; i <= to; ++i) {
+            if (htmlCache[i] === undefined && (i < renderedFrom || i > renderedTo)) {
+                if (missingFrom < 0) {
+                    missingFrom = i;
+                }
+                missingTo = i;
+            }
+        }
+
+        if (missingFrom >= 0) {
+            request(missingFrom, missingTo);
+            return;
+        }
+
+        /* 已在 DOM 中的區塊先存回快取，render 會整段重建 */
+        var children = container.children;
+        for (var k = 0; k < children.length; ++k) {
+            if (htmlCache[renderedFrom + k] === undefined) {
+                htmlCache[renderedFrom + k] = children[k].innerHTML;
+            }
+        }
+        render(from, to);
+    }
+
+    function schedule() {
+        if (!scheduled) {
+            scheduled = true;
+            window.requestAnimationFrame(update);
+        }
+    }
+
+    return {
+        /* lineCounts：每個區塊的 markdown 行數，用來估計尚未載入區塊的高度 */
+        init: function (gen, lineCounts) {
+            generation = gen;
+            count = lineCounts.length;
+            for (var i = 0; i < count; ++i) {
+                heights.push(lineCounts[i] * LINE_HEIGHT + BLOCK_SPACING);
+            }
+            rebuildOffsets();
+
+            topSpacer = document.getElementById('mdv-top');
+            container = document.getElementById('mdv-blocks');
+            bottomSpacer = document.getElementById('mdv-bottom');
+            bottomSpacer.style.height = offsets[count] + 'px';
+
+            window.addEventListener('scroll', schedule);
+            window.addEventListener('resize', schedule);
+            update();
+        },
+
+        /* 由 blocks?from=..&to=.. 回傳的腳本呼叫 */
+        receive: function (gen, from, fragments) {
+            if (pendingRequest) {
+                pendingRequest.remove();
+                pendingRequest = null;
+            }
+            /* 版本不符或沒有內容時不再呼叫 update，否則缺少的區塊會被無限次重新請求；
+               下一次捲動或改變大小時才會再試 */
+            if (gen !== generation || fragments.length === 0) {
+                return;
+            }
+            for (var i = 0; i < fragments.length; ++i) {
+                htmlCache[from + i] = fragments[i];
+            }
+            update();
+        }
+    };
+})();
@@ -0,0 +1,52 @@
+// previewbackend.h
+
+#ifndef PREVIEWBACKEND_H
+#define PREVIEWBACKEND_H
+
+#include <QObject>
+#include <QString>
+
+#include <vector>
+
+class QWidget;
+
+namespace maddy {
+struct ParsedBlock;
+}
+
+// 預覽區的共同介面：MainWindow 只負責以 maddy 轉換，顯示方式由各實作決定
+class PreviewBackend : public QObject
+{
+    Q_OBJECT
+
+public:
+
+    enum Type {
+        WebEngine,   // QWebEngineView：完整 CSS 支援，但需啟動 Chromium 行程
+        TextBrowser  // QTextBrowser：在本行程內繪製，只支援 CSS 子集，記憶體用量小
+    };
+
+    explicit PreviewBackend(QObject *parent = nullptr) : QObject(parent) {}
+    virtual ~PreviewBackend() {}
+
+    // 放進版面配置中的元件
+    virtual QWidget *widget() const = 0;
+
+    // 延後的初始化 (例如啟動 Chromium)，在視窗第一次繪製後呼叫；
+    // setContent 也會在需要時自行呼叫
+    virtual void initialize() {}
+
+    // css：套用字體大小後的樣式；baseDirectory：相對路徑圖片的基準目錄；
+    // scrollRatio：載入後要還原的捲動比例 (0 - 1)
+    virtual void setContent(const QString &css,
+                            const std::vector<maddy::ParsedBlock> &blocks,
+                            const QString &baseDirectory,
+                            qreal scrollRatio) = 0;
+
+signals:
+
+    // 新內容已實際顯示在畫面上
+    void contentShown();
+};
+
+#endif // PREVIEWBACKEND_H
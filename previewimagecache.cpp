@@ -0,0 +1,157 @@
+#include "previewimagecache.h"
+#include "taskexecutor.h"
+
+#include <QBuffer>
+#include <QFileInfo>
+#include <QFile>
+#include <QImage>
+#include <QImageReader>
+#include <QMimeDatabase>
+#include <QWebEngineUrlRequestJob>
+
+namespace {
+// 預設快取上限 64 MB
+const int kDefaultMaxBytes = 64 * 1024 * 1024;
+// 寬度超過此值的圖片會先縮小再交給 web engine
+const int kMaxImageWidth = 1600;
+
+// 在工作執行緒中讀取、解碼並縮小一張圖片；不存在或不是圖片時 data 為空
+// (呼叫前已開始監看檔案，之後才讀取修改時間，兩者之間的修改不會遺漏)
+void loadImage(const QString &filePath, QByteArray &data, QByteArray &mimeType, QDateTime &lastModified)
+{
+    lastModified = QFileInfo(filePath).lastModified();
+
+    // 以副檔名與檔案內容判斷類型：只提供圖片，MIME 類型也照實回報 (SVG 為 image/svg+xml)
+    const QString mimeName = QMimeDatabase().mimeTypeForFile(filePath).name();
+    if (!mimeName.startsWith(QLatin1String("image/"))) {
+        return;
+    }
+
+    // Qt 沒有對應外掛而無法解碼的圖片 (例如缺少 qsvg) 照原樣提供，交給 web engine 顯示
+    QImageReader reader(filePath);
+    QByteArray format = reader.canRead() ? reader.format() : QByteArray();
+    QSize size = format.isEmpty() ? QSize() : reader.size();
+
+    if (size.isValid() && size.width() > kMaxImageWidth && format != "gif" && format != "svg") {
+        // 大圖：解碼時直接縮小，再重新編碼
+        reader.setScaledSize(size.scaled(kMaxImageWidth, size.height(), Qt::KeepAspectRatio));
+        QImage image = reader.read();
+        if (!image.isNull()) {
+            QByteArray encodeFormat = image.hasAlphaChannel() ? "png" : "jpeg";
+            QBuffer buffer(&data);
+            buffer.open(QIODevice::WriteOnly);
+            image.save(&buffer, encodeFormat.constData(), 90);
+            mimeType = "image/" + encodeFormat;
+        }
+    } else {
+        // 小圖、動畫 GIF 與 SVG：直接使用原始檔案內容
+        QFile file(filePath);
+        if (file.open(QIODevice::ReadOnly)) {
+            data = file.readAll();
+            mimeType = mimeName.toLatin1();
+        }
+    }
+}
+}
+
+PreviewImageCache::PreviewImageCache(QObject *parent)
+    : QObject(parent)
+    , m_cache(kDefaultMaxBytes)
+{
+    connect(&m_watcher, &QFileSystemWatcher::fileChanged, this, &PreviewImageCache::onFileChanged);
+}
+
+void PreviewImageCache::setMaxBytes(int maxBytes)
+{
+    m_cache.setMaxCost(maxBytes);
+}
+
+void PreviewImageCache::serve(const QString &filePath, QWebEngineUrlRequestJob *job)
+{
+    if (CachedImage *image = m_cache.object(filePath)) {
+        reply(job, *image);
+        return;
+    }
+
+    // 同一張圖片只載入一次，其他請求排隊等待結果
+    bool isLoading = m_waitingJobs.contains(filePath);
+    m_waitingJobs[filePath].append(job);
+    if (isLoading) {
+        return;
+    }
+
+    // 先監看再載入，載入期間的修改會觸發 onFileChanged，不會快取到過期的內容
+    if (!m_watcher.files().contains(filePath)) {
+        m_watcher.addPath(filePath);
+    }
+
+    QPointer<QObject> receiver(this);
+    TaskExecutor::instance()->submit(TaskExecutor::Visible, "image load",
+        [receiver, filePath](const CancellationToken &) {
+            QByteArray data;
+            QByteArray mimeType;
+            QDateTime lastModified;
+            loadImage(filePath, data, mimeType, lastModified);
+            TaskExecutor::postToGui(receiver, [receiver, filePath, data, mimeType, lastModified]() {
+                static_cast<PreviewImageCache *>(receiver.data())->onImageLoaded(filePath, data, mimeType,
+                                                                                 lastModified);
+            });
+        });
+}
+
+void PreviewImageCache::onImageLoaded(const QString &filePath, const QByteArray &data,
+                                      const QByteArray &mimeType, const QDateTime &lastModified)
+{
+    const QList<QPointer<QWebEngineUrlRequestJob>> jobs = m_waitingJobs.take(filePath);
+    const bool changed = m_changedWhileLoading.remove(filePath);
+
+    if (data.isEmpty()) {
+        for (const QPointer<QWebEngineUrlRequestJob> &job : jobs) {
+            if (job) {
+                job->fail(QWebEngineUrlRequestJob::UrlNotFound);
+            }
+        }
+        m_watcher.removePath(filePath);
+        return;
+    }
+
+    CachedImage *image = new CachedImage{data, mimeType, lastModified};
+    for (const QPointer<QWebEngineUrlRequestJob> &job : jobs) {
+        if (job) {
+            reply(job, *image);
+        }
+    }
+
+    // 載入期間檔案被修改時，內容可能與修改時間不一致，下次請求重新載入
+    if (changed) {
+        delete image;
+        return;
+    }
+    m_cache.insert(filePath, image, data.size());
+}
+
+void PreviewImageCache::onFileChanged(const QString &filePath)
+{
+    if (m_waitingJobs.contains(filePath)) {
+        m_changedWhileLoading.insert(filePath);
+    }
+
+    CachedImage *image = m_cache.object(filePath);
+    QFileInfo info(filePath);
+    if (!image || !info.exists() || info.lastModified() != image->lastModified) {
+        m_cache.remove(filePath);
+    }
+
+    // 有些編輯器以「刪除後重建」的方式存檔，需要重新加入監看
+    if (info.exists() && !m_watcher.files().contains(filePath)) {
+        m_watcher.addPath(filePath);
+    }
+}
+
+void PreviewImageCache::reply(QWebEngineUrlRequestJob *job, const CachedImage &image)
+{
+    QBuffer *buffer = new QBuffer(job);
+    buffer->setData(image.data);
+    buffer->open(QIODevice::ReadOnly);
+    job->reply(image.mimeType, buffer);
+}
@@ -0,0 +1,57 @@
+// previewimagecache.h
+
+#ifndef PREVIEWIMAGECACHE_H
+#define PREVIEWIMAGECACHE_H
+
+#include <QObject>
+#include <QCache>
+#include <QDateTime>
+#include <QFileSystemWatcher>
+#include <QHash>
+#include <QList>
+#include <QPointer>
+#include <QSet>
+
+class QWebEngineUrlRequestJob;
+
+// 預覽用的本機圖片快取：在背景執行緒解碼並縮小，以 LRU 方式保存在記憶體中，
+// 檔案修改時間改變時自動失效，重新渲染時不需再讀取磁碟
+class PreviewImageCache : public QObject
+{
+    Q_OBJECT
+
+public:
+
+    explicit PreviewImageCache(QObject *parent = nullptr);
+
+    // 以本機檔案路徑回覆圖片請求；未命中快取時交給背景執行緒載入後再回覆
+    // (只提供 QMimeDatabase 判斷為圖片的檔案，其他一律回報 404)
+    void serve(const QString &filePath, QWebEngineUrlRequestJob *job);
+
+    // 快取上限 (位元組)
+    void setMaxBytes(int maxBytes);
+
+private slots:
+
+    void onFileChanged(const QString &filePath);
+
+private:
+
+    struct CachedImage
+    {
+        QByteArray data;
+        QByteArray mimeType;
+        QDateTime lastModified;
+    };
+
+    void onImageLoaded(const QString &filePath, const QByteArray &data,
+                       const QByteArray &mimeType, const QDateTime &lastModified);
+    static void reply(QWebEngineUrlRequestJob *job, const CachedImage &image);
+
+    QCache<QString, CachedImage> m_cache;
+    QHash<QString, QList<QPointer<QWebEngineUrlRequestJob>>> m_waitingJobs;
+    QFileSystemWatcher m_watcher;
+    QSet<QString> m_changedWhileLoading; // 載入期間檔案被修改，結果不放入快取
+};
+
+#endif // PREVIEWIMAGECACHE_H
@@ -0,0 +1,211 @@
+#include "previewschemehandler.h"
+#include "previewimagecache.h"
+#include "maddy/parser.h"
+
+#include <QBuffer>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QUrlQuery>
+#include <QWebEngineUrlRequestJob>
+#include <QWebEngineUrlScheme>
+
+PreviewSchemeHandler::PreviewSchemeHandler(QObject *parent)
+    : QWebEngineUrlSchemeHandler(parent)
+    , m_imageCache(new PreviewImageCache(this))
+    , m_generation(0)
+{
+}
+
+void PreviewSchemeHandler::setBaseDirectory(const QString &directory)
+{
+    if (directory != m_baseDirectory) {
+        m_baseDirectory = directory;
+        m_resolvedPaths.clear();
+    }
+}
+
+void PreviewSchemeHandler::setImageRoots(const QStringList &roots)
+{
+    m_imageRoots.clear();
+    for (const QString &root : roots) {
+        if (!root.isEmpty()) {
+            m_imageRoots.append(QDir::cleanPath(QDir(root).absolutePath()));
+        }
+    }
+    m_resolvedPaths.clear();
+}
+
+bool PreviewSchemeHandler::isAllowedPath(const QString &filePath) const
+{
+#ifdef Q_OS_WIN
+    const Qt::CaseSensitivity sensitivity = Qt::CaseInsensitive;
+#else
+    const Qt::CaseSensitivity sensitivity = Qt::CaseSensitive;
+#endif
+    // filePath 已經過 cleanPath，不含 ".."，比對目錄前綴即可
+    QStringList roots = m_imageRoots;
+    if (!m_baseDirectory.isEmpty()) {
+        roots.append(QDir::cleanPath(QDir(m_baseDirectory).absolutePath()));
+    }
+    for (const QString &root : roots) {
+        const QString prefix = root.endsWith('/') ? root : root + '/';
+        if (filePath.startsWith(prefix, sensitivity)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+QString PreviewSchemeHandler::localImagePath(const QUrl &url)
+{
+    // 頁面網址是 mdpreview://doc/current，所以 <img src="img/a.png"> 會變成 mdpreview://doc/img/a.png
+    QString path = url.path();
+
+    // 找到過的路徑直接使用，重新渲染時不必再查詢檔案系統；
+    // 檔案之後被刪除時由圖片快取的載入失敗回報 404
+    auto resolved = m_resolvedPaths.constFind(path);
+    if (resolved != m_resolvedPaths.constEnd()) {
+        return resolved.value();
+    }
+
+    QStringList candidates;
+    if (!m_baseDirectory.isEmpty()) {
+        candidates.append(QDir(m_baseDirectory).absoluteFilePath(path.mid(1)));
+    }
+    candidates.append(path);
+
+    // 只提供文件目錄或設定的圖片目錄下的檔案，其他絕對路徑一律拒絕
+    for (const QString &candidate : candidates) {
+        QString filePath = QDir::cleanPath(candidate);
+        if (isAllowedPath(filePath) && QFileInfo::exists(filePath)) {
+            m_resolvedPaths.insert(path, filePath);
+            return filePath;
+        }
+    }
+    return QString();
+}
+
+void PreviewSchemeHandler::registerScheme()
+{
+    QWebEngineUrlScheme scheme(schemeName());
+    scheme.setSyntax(QWebEngineUrlScheme::Syntax::Host);
+    scheme.setFlags(QWebEngineUrlScheme::SecureScheme | QWebEngineUrlScheme::LocalAccessAllowed);
+    QWebEngineUrlScheme::registerScheme(scheme);
+}
+
+QByteArray PreviewSchemeHandler::schemeName()
+{
+    return QByteArrayLiteral("mdpreview");
+}
+
+QUrl PreviewSchemeHandler::setDocument(const QByteArray &html)
+{
+    m_html = html;
+    m_blocks.clear();
+    ++m_generation;
+    return documentUrl();
+}
+
+QUrl PreviewSchemeHandler::setBlocks(const QByteArray &head, const std::vector<maddy::ParsedBlock> &blocks)
+{
+    ++m_generation;
+
+    m_blocks.clear();
+    m_blocks.reserve(static_cast<int>(blocks.size()));
+    QByteArray lineCounts;
+    for (const maddy::ParsedBlock &block : blocks) {
+        m_blocks.append(QByteArray::fromStdString(block.html));
+        if (!lineCounts.isEmpty()) {
+            lineCounts += ',';
+        }
+        lineCounts += QByteArray::number(static_cast<qulonglong>(block.lineCount));
+    }
+
+    QByteArray script;
+    QFile scriptFile(":/preview_virtual.js");
+    if (scriptFile.open(QIODevice::ReadOnly)) {
+        script = scriptFile.readAll();
+    }
+
+    // 外殼頁面只有上下兩個撐高度的空白元素與區塊容器，實際內容由 preview_virtual.js 取回
+    m_html = "<!DOCTYPE html><html><head><meta charset=\"utf-8\">"
+             + head
+             + "</head><body>"
+               "<div id=\"mdv-top\"></div><div id=\"mdv-blocks\"></div><div id=\"mdv-bottom\"></div>"
+               "<script>"
+             + script
+             + "\nmdv.init(" + QByteArray::number(m_generation) + ", [" + lineCounts + "]);"
+               "</script></body></html>";
+    return documentUrl();
+}
+
+QUrl PreviewSchemeHandler::documentUrl() const
+{
+    QUrl url;
+    url.setScheme(QString::fromLatin1(schemeName()));
+    url.setHost("doc");
+    url.setPath("/current");
+    url.setQuery(QString("v=%1").arg(m_generation));
+    return url;
+}
+
+void PreviewSchemeHandler::requestStarted(QWebEngineUrlRequestJob *job)
+{
+    const QUrl url = job->requestUrl();
+    if (url.host() != "doc") {
+        job->fail(QWebEngineUrlRequestJob::UrlNotFound);
+        return;
+    }
+
+    if (url.path() == "/blocks") {
+        QBuffer *buffer = new QBuffer(job);
+        buffer->setData(blocksScript(url));
+        buffer->open(QIODevice::ReadOnly);
+        job->reply(QByteArrayLiteral("application/javascript"), buffer);
+        return;
+    }
+
+    // 文件以外的請求視為本機圖片，交給記憶體快取處理
+    if (url.path() != "/current") {
+        QString filePath = localImagePath(url);
+        if (filePath.isEmpty()) {
+            job->fail(QWebEngineUrlRequestJob::UrlNotFound);
+            return;
+        }
+        m_imageCache->serve(filePath, job);
+        return;
+    }
+
+    // QByteArray 為隱式共用，這裡不會複製內容；
+    // web engine 會從 buffer 分段讀取，邊讀邊解析與繪製
+    QBuffer *buffer = new QBuffer(job);
+    buffer->setData(m_html);
+    buffer->open(QIODevice::ReadOnly);
+    job->reply(QByteArrayLiteral("text/html"), buffer);
+}
+
+QByteArray PreviewSchemeHandler::blocksScript(const QUrl &url) const
+{
+    // 以 <script src> 回傳 (JSONP)，Qt 5.12 對自訂 scheme 的 fetch/XHR 支援不完整
+    const QUrlQuery query(url);
+    const quint64 generation = query.queryItemValue("v").toULongLong();
+    int from = query.queryItemValue("from").toInt();
+    int to = query.queryItemValue("to").toInt();
+
+    // 舊版本頁面的請求不回傳內容，並回傳目前的版本號，
+    // 頁面收到不同的版本號會捨棄回應，不會再次請求同一段
+    QJsonArray fragments;
+    if (generation == m_generation) {
+        from = qMax(0, from);
+        to = qMin(to, m_blocks.size() - 1);
+        for (int i = from; i <= to; ++i) {
+            fragments.append(QString::fromUtf8(m_blocks.at(i)));
+        }
+    }
+
+    return "mdv.receive(" + QByteArray::number(m_generation) + ", " + QByteArray::number(from) + ", "
+           + QJsonDocument(fragments).toJson(QJsonDocument::Compact) + ");";
+}
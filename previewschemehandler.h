@@ -0,0 +1,67 @@
+// previewschemehandler.h
+
+#ifndef PREVIEWSCHEMEHANDLER_H
+#define PREVIEWSCHEMEHANDLER_H
+
+#include <QWebEngineUrlSchemeHandler>
+#include <QByteArray>
+#include <QHash>
+#include <QStringList>
+#include <QUrl>
+#include <QVector>
+
+#include <vector>
+
+namespace maddy {
+struct ParsedBlock;
+}
+
+class PreviewImageCache;
+
+// 以自訂網址 (mdpreview://doc/current) 從記憶體提供預覽 HTML，
+// 取代 setHtml 的 data URL，沒有 2 MB 的上限
+class PreviewSchemeHandler : public QWebEngineUrlSchemeHandler
+{
+    Q_OBJECT
+
+public:
+
+    explicit PreviewSchemeHandler(QObject *parent = nullptr);
+
+    // 必須在建立 QApplication 之前呼叫
+    static void registerScheme();
+
+    static QByteArray schemeName();
+
+    // 更新目前的預覽內容，並回傳載入用的網址 (帶有版本號，避免重用舊的回應)
+    QUrl setDocument(const QByteArray &html);
+
+    // 超大文件改用虛擬化預覽：只送出外殼頁面，區塊內容由頁面依捲動位置分批取回
+    // (mdpreview://doc/blocks?v=&from=&to=)；head 為放進 <head> 的內容 (樣式)
+    QUrl setBlocks(const QByteArray &head, const std::vector<maddy::ParsedBlock> &blocks);
+
+    // 相對路徑的圖片以此目錄 (目前檔案所在位置) 為基準
+    void setBaseDirectory(const QString &directory);
+
+    // 除了文件所在目錄外，也允許提供這些目錄 (含子目錄) 下的圖片
+    void setImageRoots(const QStringList &roots);
+
+    void requestStarted(QWebEngineUrlRequestJob *job) override;
+
+private:
+
+    QUrl documentUrl() const;
+    QString localImagePath(const QUrl &url);
+    bool isAllowedPath(const QString &filePath) const;
+    QByteArray blocksScript(const QUrl &url) const;
+
+    QByteArray m_html;
+    QVector<QByteArray> m_blocks;
+    QString m_baseDirectory;
+    QStringList m_imageRoots;
+    QHash<QString, QString> m_resolvedPaths; // 網址路徑 -> 已確認存在的檔案路徑
+    PreviewImageCache *m_imageCache;
+    quint64 m_generation;
+};
+
+#endif // PREVIEWSCHEMEHANDLER_H
@@ -0,0 +1,50 @@
+#include "rendercache.h"
+#include "contenthash.h"
+#include "maddy/parser.h"
+
+#include <climits>
+
+RenderCache::RenderCache(int maxBytes)
+    : m_cache(maxBytes)
+    , m_hits(0)
+    , m_misses(0)
+{
+}
+
+quint64 RenderCache::key(const QString &markdown, quint32 enabledParsers)
+{
+    return ContentHash().add(markdown).add(static_cast<quint64>(enabledParsers)).value();
+}
+
+RenderCache::Blocks RenderCache::find(quint64 key)
+{
+    if (Entry *entry = m_cache.object(key)) {
+        ++m_hits;
+        return entry->blocks;
+    }
+    ++m_misses;
+    return Blocks();
+}
+
+RenderCache::Blocks RenderCache::peek(quint64 key)
+{
+    Entry *entry = m_cache.object(key);
+    return entry ? entry->blocks : Blocks();
+}
+
+void RenderCache::insert(quint64 key, const Blocks &blocks)
+{
+    size_t bytes = 0;
+    for (const maddy::ParsedBlock &block : *blocks) {
+        bytes += block.html.size();
+    }
+
+    // 超過上限的單一結果 QCache 會直接丟棄
+    m_cache.insert(key, new Entry{blocks}, static_cast<int>(qMin<size_t>(bytes, INT_MAX)));
+}
+
+double RenderCache::hitRate() const
+{
+    int total = m_hits + m_misses;
+    return total > 0 ? double(m_hits) / total : 0.0;
+}
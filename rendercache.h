@@ -0,0 +1,51 @@
+// rendercache.h
+
+#ifndef RENDERCACHE_H
+#define RENDERCACHE_H
+
+#include <QCache>
+#include <QString>
+
+#include <memory>
+#include <vector>
+
+namespace maddy {
+struct ParsedBlock;
+}
+
+// 預覽轉換結果的 LRU 快取：以 (markdown 文字, parser 設定) 的 64 位元內容雜湊為鍵。
+// 復原到先前的內容、計時器空轉、切回同一個檔案時都不必重新轉換
+class RenderCache
+{
+public:
+
+    typedef std::shared_ptr<const std::vector<maddy::ParsedBlock>> Blocks;
+
+    // maxBytes：所有快取區塊 HTML 的總大小上限
+    explicit RenderCache(int maxBytes = 32 * 1024 * 1024);
+
+    static quint64 key(const QString &markdown, quint32 enabledParsers);
+
+    // 未命中時回傳空指標；命中與未命中都會計入統計
+    Blocks find(quint64 key);
+    // 與 find 相同但不計入統計，例如寫入磁碟快取時取用
+    Blocks peek(quint64 key);
+    void insert(quint64 key, const Blocks &blocks);
+
+    int hits() const { return m_hits; }
+    int misses() const { return m_misses; }
+    double hitRate() const;
+
+private:
+
+    struct Entry
+    {
+        Blocks blocks;
+    };
+
+    QCache<quint64, Entry> m_cache;
+    int m_hits;
+    int m_misses;
+};
+
+#endif // RENDERCACHE_H
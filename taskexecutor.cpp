@@ -0,0 +1,120 @@
+#include "taskexecutor.h"
+
+#include <QCoreApplication>
+#include <QMutexLocker>
+#include <QRunnable>
+#include <QThread>
+
+// QThreadPool 依優先順序取出排隊中的工作；這裡只負責取消檢查與計時
+class ExecutorTask : public QRunnable
+{
+public:
+    ExecutorTask(TaskExecutor *executor, TaskExecutor::Priority priority, const QString &category,
+                 const CancellationToken &token, std::function<void(const CancellationToken &)> work)
+        : m_executor(executor)
+        , m_priority(priority)
+        , m_category(category)
+        , m_token(token)
+        , m_work(work)
+    {
+    }
+
+    void run() override
+    {
+        m_executor->run(m_priority, m_category, m_token, m_work);
+    }
+
+private:
+    TaskExecutor *m_executor;
+    TaskExecutor::Priority m_priority;
+    QString m_category;
+    CancellationToken m_token;
+    std::function<void(const CancellationToken &)> m_work;
+};
+
+TaskExecutor::TaskExecutor(QObject *parent)
+    : QObject(parent)
+    , m_busyNs(0)
+{
+    m_pool.setMaxThreadCount(qMax(2, QThread::idealThreadCount()));
+    m_stats.maxThreads = m_pool.maxThreadCount();
+    m_sampleTimer.start();
+}
+
+TaskExecutor::~TaskExecutor()
+{
+    // 執行中與排隊中的工作都會用到 m_mutex 與 m_stats，
+    // 必須在這些成員解構之前等它們完成 (m_pool 是第一個成員，最後才解構)
+    m_pool.waitForDone();
+}
+
+TaskExecutor *TaskExecutor::instance()
+{
+    // 隨 QApplication 一起結束；解構時會等待執行中與排隊中的工作
+    static TaskExecutor *executor = new TaskExecutor(qApp);
+    return executor;
+}
+
+CancellationToken TaskExecutor::submit(Priority priority, const QString &category,
+                                       std::function<void(const CancellationToken &)> work)
+{
+    CancellationToken token;
+    {
+        QMutexLocker locker(&m_mutex);
+        ++m_stats.queued[priority];
+        ++m_stats.categories[category].submitted;
+    }
+    m_pool.start(new ExecutorTask(this, priority, category, token, work), priority);
+    return token;
+}
+
+void TaskExecutor::postToGui(const QPointer<QObject> &receiver, std::function<void()> function)
+{
+    QMetaObject::invokeMethod(qApp, [receiver, function]() {
+        if (receiver) {
+            function();
+        }
+    }, Qt::QueuedConnection);
+}
+
+void TaskExecutor::run(Priority priority, const QString &category, const CancellationToken &token,
+                       const std::function<void(const CancellationToken &)> &work)
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        --m_stats.queued[priority];
+        if (token.isCancelled()) {
+            ++m_stats.categories[category].cancelled;
+            return;
+        }
+        ++m_stats.running;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    work(token);
+    qint64 elapsedNs = timer.nsecsElapsed();
+
+    QMutexLocker locker(&m_mutex);
+    --m_stats.running;
+    m_busyNs += elapsedNs;
+    CategoryStats &stats = m_stats.categories[category];
+    if (token.isCancelled()) {
+        ++stats.cancelled;
+    } else {
+        ++stats.completed;
+    }
+    stats.totalNs += elapsedNs;
+    stats.maxNs = qMax(stats.maxNs, elapsedNs);
+}
+
+TaskExecutor::Stats TaskExecutor::takeStats()
+{
+    QMutexLocker locker(&m_mutex);
+    Stats stats = m_stats;
+    qint64 windowNs = m_sampleTimer.nsecsElapsed() * m_stats.maxThreads;
+    stats.utilization = windowNs > 0 ? qMin(1.0, double(m_busyNs) / windowNs) : 0.0;
+    m_busyNs = 0;
+    m_sampleTimer.restart();
+    return stats;
+}
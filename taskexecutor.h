@@ -0,0 +1,99 @@
+// taskexecutor.h
+
+#ifndef TASKEXECUTOR_H
+#define TASKEXECUTOR_H
+
+#include <QObject>
+#include <QMap>
+#include <QMutex>
+#include <QElapsedTimer>
+#include <QPointer>
+#include <QString>
+#include <QThreadPool>
+
+#include <atomic>
+#include <functional>
+#include <memory>
+
+// 取消旗標：提交工作時取得，任何執行緒都可以要求取消。
+// 尚未開始的工作會直接略過，執行中的工作則應在適當的地方檢查 isCancelled()
+class CancellationToken
+{
+public:
+
+    CancellationToken() : m_cancelled(std::make_shared<std::atomic<bool>>(false)) {}
+
+    void cancel() const { m_cancelled->store(true); }
+    bool isCancelled() const { return m_cancelled->load(); }
+
+private:
+
+    std::shared_ptr<std::atomic<bool>> m_cancelled;
+};
+
+// 全程式共用的背景工作執行器：預覽轉換、語法標示斷詞、圖片與檔案讀取、暖機都經由這裡，
+// 不再各自建立執行緒。工作依優先順序排隊，並記錄各類別的執行時間
+class TaskExecutor : public QObject
+{
+    Q_OBJECT
+
+public:
+
+    enum Priority {
+        Background = 0,   // 暖機等可以慢慢做的工作
+        Visible = 1,      // 畫面上看得到的結果 (語法標示、圖片)
+        Interactive = 2,  // 使用者正在等待的結果 (預覽、開啟檔案)
+        PriorityCount = 3
+    };
+
+    struct CategoryStats
+    {
+        int submitted = 0;
+        int completed = 0;
+        int cancelled = 0;
+        qint64 totalNs = 0;
+        qint64 maxNs = 0;
+    };
+
+    struct Stats
+    {
+        int queued[PriorityCount] = {0, 0, 0};
+        int running = 0;
+        int maxThreads = 0;
+        double utilization = 0.0; // 上次取樣以來工作執行緒的忙碌比例 (0 - 1)
+        QMap<QString, CategoryStats> categories;
+    };
+
+    static TaskExecutor *instance();
+
+    ~TaskExecutor();
+
+    // work 在工作執行緒上執行；category 用於統計 (例如 "preview parse")
+    CancellationToken submit(Priority priority, const QString &category,
+                             std::function<void(const CancellationToken &)> work);
+
+    // 把結果送回 GUI 執行緒；receiver 已被刪除時不執行。
+    // receiver 的 QPointer 必須在 GUI 執行緒建立 (通常在 submit 之前)
+    static void postToGui(const QPointer<QObject> &receiver, std::function<void()> function);
+
+    // 取得統計資料，並開始下一段忙碌比例的取樣
+    Stats takeStats();
+
+private:
+
+    explicit TaskExecutor(QObject *parent = nullptr);
+
+    void run(Priority priority, const QString &category, const CancellationToken &token,
+             const std::function<void(const CancellationToken &)> &work);
+
+    QThreadPool m_pool;
+
+    mutable QMutex m_mutex;
+    Stats m_stats;
+    qint64 m_busyNs;
+    QElapsedTimer m_sampleTimer;
+
+    friend class ExecutorTask;
+};
+
+#endif // TASKEXECUTOR_H
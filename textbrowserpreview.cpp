@@ -0,0 +1,49 @@
+#include "textbrowserpreview.h"
+#include "maddy/parser.h"
+
+#include <QScrollBar>
+#include <QTextBrowser>
+
+TextBrowserPreview::TextBrowserPreview(QWidget *parentWidget, QObject *parent)
+    : PreviewBackend(parent)
+    , m_browser(new QTextBrowser(parentWidget))
+{
+    m_browser->setObjectName("preview");
+    m_browser->setOpenExternalLinks(true);
+}
+
+TextBrowserPreview::~TextBrowserPreview()
+{
+    delete m_browser;
+}
+
+QWidget *TextBrowserPreview::widget() const
+{
+    return m_browser;
+}
+
+void TextBrowserPreview::setContent(const QString &css,
+                                    const std::vector<maddy::ParsedBlock> &blocks,
+                                    const QString &baseDirectory,
+                                    qreal scrollRatio)
+{
+    std::string body;
+    size_t totalSize = 0;
+    for (const maddy::ParsedBlock &block : blocks) {
+        totalSize += block.html.size();
+    }
+    body.reserve(totalSize);
+    for (const maddy::ParsedBlock &block : blocks) {
+        body += block.html;
+    }
+
+    // 不支援的 CSS 屬性會被 QTextDocument 忽略，所以直接沿用同一份樣式
+    m_browser->document()->setDefaultStyleSheet(css);
+    m_browser->setSearchPaths(baseDirectory.isEmpty() ? QStringList() : QStringList(baseDirectory));
+    m_browser->setHtml(QString::fromStdString(body));
+
+    // setHtml 是同步排版，可以直接還原捲動位置
+    QScrollBar *scrollBar = m_browser->verticalScrollBar();
+    scrollBar->setValue(qRound(scrollBar->maximum() * scrollRatio));
+    emit contentShown();
+}
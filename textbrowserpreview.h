@@ -0,0 +1,35 @@
+// textbrowserpreview.h
+
+#ifndef TEXTBROWSERPREVIEW_H
+#define TEXTBROWSERPREVIEW_H
+
+#include "previewbackend.h"
+
+#include <QPointer>
+
+class QTextBrowser;
+
+// 以 QTextBrowser 顯示預覽：不需要 Chromium，啟動快、記憶體用量小，
+// 但 QTextDocument 只支援部分 HTML 與 CSS
+class TextBrowserPreview : public PreviewBackend
+{
+    Q_OBJECT
+
+public:
+
+    explicit TextBrowserPreview(QWidget *parentWidget, QObject *parent = nullptr);
+    ~TextBrowserPreview() override;
+
+    QWidget *widget() const override;
+
+    void setContent(const QString &css,
+                    const std::vector<maddy::ParsedBlock> &blocks,
+                    const QString &baseDirectory,
+                    qreal scrollRatio) override;
+
+private:
+
+    QPointer<QTextBrowser> m_browser; // 由版面配置的父元件持有，關閉視窗時可能先被刪除
+};
+
+#endif // TEXTBROWSERPREVIEW_H
@@ -0,0 +1,158 @@
+#include "webenginepreview.h"
+#include "previewschemehandler.h"
+#include "maddy/parser.h"
+
+#include <QLabel>
+#include <QSettings>
+#include <QStackedLayout>
+#include <QWebEnginePage>
+#include <QWebEngineProfile>
+#include <QWebEngineView>
+
+namespace {
+// 預覽 HTML 超過此大小 (位元組) 或區塊數時改用虛擬化預覽
+const size_t kVirtualPreviewSize = 2 * 1024 * 1024;
+const size_t kVirtualPreviewBlocks = 5000;
+// 文件目錄以外允許預覽圖片的目錄清單
+const char kImageRootsKey[] = "preview/imageRoots";
+}
+
+WebEnginePreview::WebEnginePreview(QWidget *parentWidget, QObject *parent)
+    : PreviewBackend(parent)
+    , m_widget(new QWidget(parentWidget))
+    , m_stack(new QStackedLayout(m_widget))
+    , m_placeholder(nullptr)
+    , m_front(nullptr)
+    , m_generation(0)
+    , m_scrollRatio(0.0)
+    , m_scheme(new PreviewSchemeHandler(this))
+{
+    m_buffers[0] = nullptr;
+    m_buffers[1] = nullptr;
+    m_bufferGeneration[0] = 0;
+    m_bufferGeneration[1] = 0;
+
+    // StackAll 讓兩個 view 都保持可見 (後景只是被蓋住)，後景才會實際繪製
+    m_stack->setContentsMargins(0, 0, 0, 0);
+    m_stack->setStackingMode(QStackedLayout::StackAll);
+
+    QLabel *placeholder = new QLabel("預覽載入中...", m_widget);
+    placeholder->setObjectName("previewPlaceholder");
+    placeholder->setAlignment(Qt::AlignCenter);
+    m_placeholder = placeholder;
+    m_stack->addWidget(m_placeholder);
+
+    m_scheme->setImageRoots(QSettings().value(kImageRootsKey).toStringList());
+}
+
+WebEnginePreview::~WebEnginePreview()
+{
+    // 切換預覽引擎後可能再建立新的實例，先移除 scheme handler 才能重新安裝
+    // (尚未初始化時不可呼叫 defaultProfile()，否則會為此啟動 Chromium)
+    if (m_front) {
+        QWebEngineProfile::defaultProfile()->removeUrlSchemeHandler(m_scheme);
+    }
+    delete m_widget;
+}
+
+void WebEnginePreview::initialize()
+{
+    if (m_front) {
+        return;
+    }
+
+    for (int i = 0; i < 2; ++i) {
+        m_buffers[i] = new QWebEngineView(m_widget);
+        m_buffers[i]->setObjectName("preview");
+        m_stack->addWidget(m_buffers[i]);
+        connect(m_buffers[i], &QWebEngineView::loadFinished, this, [this, i](bool ok) {
+            onLoadFinished(i, ok);
+        });
+    }
+    m_front = m_buffers[0];
+    m_stack->setCurrentWidget(m_front);
+    delete m_placeholder;
+    m_placeholder = nullptr;
+
+    // 預覽內容經由自訂網址從記憶體串流提供，不再受 setHtml 的大小限制
+    // (兩個 view 都使用預設 profile，只需安裝一次)
+    QWebEngineProfile::defaultProfile()->installUrlSchemeHandler(PreviewSchemeHandler::schemeName(), m_scheme);
+}
+
+QWidget *WebEnginePreview::widget() const
+{
+    return m_widget;
+}
+
+void WebEnginePreview::setContent(const QString &css,
+                                  const std::vector<maddy::ParsedBlock> &blocks,
+                                  const QString &baseDirectory,
+                                  qreal scrollRatio)
+{
+    initialize();
+    m_scrollRatio = scrollRatio;
+    QByteArray head = "<style>" + css.toUtf8() + "</style>";
+
+    size_t totalSize = 0;
+    for (const maddy::ParsedBlock &block : blocks) {
+        totalSize += block.html.size();
+    }
+
+    // 相對路徑的圖片以目前檔案所在目錄為基準，經由圖片快取提供
+    m_scheme->setBaseDirectory(baseDirectory);
+
+    // 超大文件只把可見範圍的區塊放進 DOM，避免一次排版數萬個元素
+    if (totalSize > kVirtualPreviewSize || blocks.size() > kVirtualPreviewBlocks) {
+        load(m_scheme->setBlocks(head, blocks));
+        return;
+    }
+
+    QByteArray body;
+    body.reserve(static_cast<int>(totalSize));
+    for (const maddy::ParsedBlock &block : blocks) {
+        body.append(block.html.data(), static_cast<int>(block.html.size()));
+    }
+
+    QByteArray fullHtml = "<!DOCTYPE html><html><head><meta charset=\"utf-8\">"
+                          + head
+                          + "</head><body>"
+                          + body
+                          + "</body></html>";
+    load(m_scheme->setDocument(fullHtml));
+}
+
+void WebEnginePreview::load(const QUrl &url)
+{
+    // 一律載入到後景；若後景還在載入上一版，load 會直接取代它
+    int back = (m_front == m_buffers[0]) ? 1 : 0;
+    m_bufferGeneration[back] = ++m_generation;
+    m_buffers[back]->load(url);
+}
+
+void WebEnginePreview::onLoadFinished(int buffer, bool ok)
+{
+    // 已有更新的版本在載入中 (或此次載入被中斷)，不切換，等最新版完成
+    if (!ok || m_bufferGeneration[buffer] != m_generation || m_buffers[buffer] == m_front) {
+        return;
+    }
+
+    QString script = QString(
+        "const scrollHeight = document.body.scrollHeight - window.innerHeight;"
+        "window.scrollTo(0, scrollHeight * %1);"
+    ).arg(m_scrollRatio);
+
+    // 捲動位置在後景還原完成後才切換，切換後第一個畫面就是正確位置
+    quint64 generation = m_generation;
+    m_buffers[buffer]->page()->runJavaScript(script, [this, buffer, generation](const QVariant &) {
+        if (generation == m_generation) {
+            swapBuffers(buffer);
+        }
+    });
+}
+
+void WebEnginePreview::swapBuffers(int buffer)
+{
+    m_front = m_buffers[buffer];
+    m_stack->setCurrentWidget(m_front);
+    emit contentShown();
+}
@@ -0,0 +1,53 @@
+// webenginepreview.h
+
+#ifndef WEBENGINEPREVIEW_H
+#define WEBENGINEPREVIEW_H
+
+#include "previewbackend.h"
+
+#include <QPointer>
+
+class QStackedLayout;
+class QUrl;
+class QWebEngineView;
+class PreviewSchemeHandler;
+
+// 以 QWebEngineView 顯示預覽，內容經由 mdpreview:// 從記憶體提供。
+// 採雙緩衝：新內容在被遮住的後景 view 載入並還原捲動位置後才切換到前景。
+// 建立 view 會啟動 Chromium，所以延到 initialize() 才做，在此之前先顯示佔位元件
+class WebEnginePreview : public PreviewBackend
+{
+    Q_OBJECT
+
+public:
+
+    explicit WebEnginePreview(QWidget *parentWidget, QObject *parent = nullptr);
+    ~WebEnginePreview() override;
+
+    QWidget *widget() const override;
+
+    void initialize() override;
+
+    void setContent(const QString &css,
+                    const std::vector<maddy::ParsedBlock> &blocks,
+                    const QString &baseDirectory,
+                    qreal scrollRatio) override;
+
+private:
+
+    void load(const QUrl &url);
+    void onLoadFinished(int buffer, bool ok);
+    void swapBuffers(int buffer);
+
+    QPointer<QWidget> m_widget; // 由版面配置的父元件持有，關閉視窗時可能先被刪除
+    QStackedLayout *m_stack;
+    QWidget *m_placeholder;
+    QWebEngineView *m_front; // 目前顯示中的 view (前景緩衝)
+    QWebEngineView *m_buffers[2];
+    quint64 m_bufferGeneration[2];
+    quint64 m_generation;
+    qreal m_scrollRatio;
+    PreviewSchemeHandler *m_scheme;
+};
+
+#endif // WEBENGINEPREVIEW_H